@@ -0,0 +1,16 @@
+#ifndef COMPRESSED_TEXTURE_H
+#define COMPRESSED_TEXTURE_H
+
+#include <glad/glad.h>
+
+#include <string>
+
+// Creates a GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP from a KTX file written by the asset baker,
+// every mip level goes straight to glCompressedTexImage2D with no decoding. Returns 0 when
+// the file is missing, malformed, of the wrong kind, baked in the other orientation than
+// flipVertically asks for, or the driver lacks the format, callers then fall back to the
+// source image. The wrap modes are left to the caller.
+unsigned int loadCompressedTexture(const std::string &path, GLenum target, bool flipVertically,
+                                   bool *hasAlpha = nullptr);
+
+#endif
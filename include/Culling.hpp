@@ -0,0 +1,54 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+struct BoundingSphere
+{
+    glm::vec3 center;
+    float radius;
+};
+
+// Bounds of a sphere after an affine transform, the radius grows with the largest axis scale
+BoundingSphere transformSphere(const BoundingSphere &sphere, const glm::mat4 &transform);
+
+// The six planes of a view-projection matrix, normals point inside
+class Frustum
+{
+public:
+    glm::vec4 planes[6];
+
+    Frustum(const glm::mat4 &viewProjection);
+
+    bool Intersects(const BoundingSphere &sphere) const;
+};
+
+// Collects the bounding spheres of everything that may be drawn this frame in
+// structure-of-arrays form and tests them against the frustum four at a time.
+// Add returns the index the visibility of the sphere is read back at.
+class CullingStage
+{
+    std::vector<float> x, y, z, radius;
+    std::vector<unsigned char> visible;
+    size_t count;
+    size_t visibleCount;
+public:
+    CullingStage();
+
+    void Begin();
+    size_t Add(const BoundingSphere &sphere);
+    void Run(const glm::mat4 &viewProjection);
+
+    bool IsVisible(size_t index) const { return visible[index]; }
+    // Visibility flags starting at index, one byte per sphere
+    const unsigned char* Visibility(size_t index = 0) const { return visible.data() + index; }
+
+    size_t Size() const { return count; }
+    size_t Submitted() const { return visibleCount; }
+    size_t Culled() const { return count - visibleCount; }
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <cstddef>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <StreamBuffer.hpp>
+
+// Fixed binding points of the uniform blocks shared by all programs
+enum UniformBinding {
+    FrameDataBinding = 0,
+    LightDataBinding = 1,
+    ObjectDataBinding = 3
+};
+
+// std140 mirror of the FrameData block, everything is vec4 aligned so there is no hidden padding
+struct FrameData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    // view without the translation, for the skybox
+    glm::mat4 skyboxView;
+    // xyz used
+    glm::vec4 viewPosition;
+};
+
+// std140 mirror of the PointLight struct in the shaders, vec3s are stored as vec4s
+struct GpuPointLight {
+    glm::vec4 position;
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+    // constant, linear, quadratic, unused
+    glm::vec4 attenuation;
+};
+
+// Must match MAX_POINT_LIGHTS in the shaders
+const int MaxPointLights = 4;
+
+// std140 mirror of the LightData block
+struct LightData {
+    int pointLightCount;
+    int padding[3];
+    GpuPointLight pointLights[MaxPointLights];
+};
+
+// std140 mirror of the ObjectData block, the transform of one object drawn on its own
+struct ObjectData {
+    glm::mat4 model;
+    // mat3 columns are vec4 aligned
+    glm::vec4 normalMatrix[3];
+    float scale;
+    float padding[3];
+};
+
+static_assert(offsetof(FrameData, projection) == 64, "FrameData does not match std140");
+static_assert(offsetof(FrameData, skyboxView) == 128, "FrameData does not match std140");
+static_assert(offsetof(FrameData, viewPosition) == 192, "FrameData does not match std140");
+static_assert(sizeof(FrameData) == 208, "FrameData does not match std140");
+static_assert(sizeof(GpuPointLight) == 80, "GpuPointLight does not match std140");
+static_assert(offsetof(LightData, pointLights) == 16, "LightData does not match std140");
+static_assert(sizeof(LightData) == 16 + 80 * MaxPointLights, "LightData does not match std140");
+static_assert(offsetof(ObjectData, scale) == 112, "ObjectData does not match std140");
+static_assert(sizeof(ObjectData) == 128, "ObjectData does not match std140");
+
+// Writes an ObjectData block into the frame's stream buffer, returns where it went (pointer null if full)
+StreamAllocation writeObjectData(StreamBuffer &stream, const glm::mat4 &model, const glm::mat3 &normalMatrix,
+                                 float scale);
+
+// Fills the FrameData and LightData blocks once per frame from the frame's stream buffer
+// and binds them to their binding points, so every program that declares the blocks
+// sees the same camera and lights without per-program uniforms.
+class FrameUniforms
+{
+public:
+    FrameUniforms();
+
+    void SetCamera(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &viewPosition);
+
+    // Lights are collected between ClearLights and Upload, extra lights past MaxPointLights are dropped
+    void ClearLights();
+    void AddPointLight(const glm::vec3 &position, const glm::vec3 &ambient, const glm::vec3 &diffuse,
+                       const glm::vec3 &specular, float constant, float linear, float quadratic);
+
+    // Writes both blocks into stream and binds them, once per frame before drawing
+    void Upload(StreamBuffer &stream);
+
+    // Points the blocks a program declares at the fixed binding points, GLSL 330 has no binding layout qualifier
+    static void BindBlocks(unsigned int program);
+
+private:
+    FrameData frame;
+    LightData lights;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+// The loader only covers GL 3.3 core, newer entry points the renderer can take
+// advantage of are loaded here and used only when the matching flag is set.
+
+// GL 4.1 / ARB_get_program_binary
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// KHR_parallel_shader_compile / ARB_parallel_shader_compile, the ARB tokens have the same values
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// GL 4.3 / ARB_multi_draw_indirect and ARB_shader_storage_buffer_object
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+
+#ifndef GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#endif
+
+// GL 4.4 / ARB_buffer_storage
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// EXT_texture_compression_s3tc, BC1 and BC3
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYEXTPROC)(GLuint program, GLsizei bufSize, GLsizei *length,
+                                                       GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYEXTPROC)(GLuint program, GLenum binaryFormat, const void *binary,
+                                                    GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIEXTPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSEXTPROC)(GLuint count);
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEEXTPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTEXTPROC)(GLenum mode, GLenum type, const void *indirect,
+                                                                GLsizei drawcount, GLsizei stride);
+
+class GLExtensions
+{
+public:
+    // Call once after the GL 3.3 functions are loaded, with the same loader
+    static void Load(GLADloadproc loader);
+
+    static bool Supported(const char *extension);
+    static bool Version(int major, int minor);
+
+    // glGetProgramBinary, glProgramBinary and glProgramParameteri
+    static bool HasProgramBinary;
+    static PFNGLGETPROGRAMBINARYEXTPROC GetProgramBinary;
+    static PFNGLPROGRAMBINARYEXTPROC ProgramBinary;
+    static PFNGLPROGRAMPARAMETERIEXTPROC ProgramParameteri;
+
+    // GL_COMPLETION_STATUS_KHR can be polled and compiles run on driver threads
+    static bool HasParallelShaderCompile;
+    static PFNGLMAXSHADERCOMPILERTHREADSEXTPROC MaxShaderCompilerThreads;
+
+    // glMultiDrawElementsIndirect, shader storage buffers and gl_DrawIDARB are all available,
+    // shaders enable GL_ARB_shader_storage_buffer_object, GL_ARB_shader_draw_parameters
+    // and GL_ARB_shading_language_420pack themselves
+    static bool HasMultiDrawIndirect;
+    static PFNGLMULTIDRAWELEMENTSINDIRECTEXTPROC MultiDrawElementsIndirect;
+
+    // glBufferStorage, buffers can stay mapped while the GPU reads them
+    static bool HasBufferStorage;
+    static PFNGLBUFFERSTORAGEEXTPROC BufferStorage;
+
+    // BC1/BC3 textures can be uploaded with glCompressedTexImage2D, core entry point, no function to load
+    static bool HasTextureCompressionS3TC;
+};
+
+#endif
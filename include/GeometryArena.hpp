@@ -0,0 +1,99 @@
+#ifndef GEOMETRY_ARENA_H
+#define GEOMETRY_ARENA_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+// First-fit allocator over a range of elements, adjacent free blocks are merged on release
+class FreeList
+{
+    // offset -> size of every free block
+    std::map<size_t, size_t> blocks;
+    size_t capacity;
+public:
+    FreeList(size_t capacity = 0);
+
+    // Returns false when no free block is large enough
+    bool Allocate(size_t count, size_t &offset);
+    void Free(size_t offset, size_t count);
+    // Extends the range, the new space is free
+    void Grow(size_t newCapacity);
+
+    size_t Capacity() const { return capacity; }
+};
+
+struct VertexAttribute
+{
+    GLuint index;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    size_t offset;
+};
+
+// Where a mesh lives inside an arena, drawn with glDrawElementsBaseVertex.
+// Indices are relative to baseVertex, so any range of up to 65536 vertices uses 16 bit indices.
+struct GeometryRange
+{
+    unsigned int baseVertex;
+    unsigned int vertexCount;
+    // byte offset into the index buffer, always 4 byte aligned
+    size_t indexOffset;
+    unsigned int indexCount;
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLenum indexType;
+};
+
+// One large VBO/EBO pair and one VAO shared by every mesh of the same vertex format.
+// Buffers grow by doubling when full, which replaces them, so VAOs built elsewhere
+// on top of the arena buffers should re-run SetupVertexAttributes when Generation changes.
+// The index buffer holds both 16 and 32 bit ranges and is allocated in 4 byte slots.
+class GeometryArena
+{
+    unsigned int VAO, VBO, EBO;
+    size_t stride;
+    std::vector<VertexAttribute> attributes;
+    FreeList vertexSpace, indexSpace;
+    unsigned int generation;
+    size_t indexBytes;
+
+    void growVertices(size_t minVertices);
+    void growIndices(size_t minSlots);
+    static size_t indexSlots(unsigned int indexCount, GLenum indexType);
+    static unsigned int resize(unsigned int buffer, size_t oldBytes, size_t newBytes);
+public:
+    // Largest vertex count a range can have and still use 16 bit indices
+    static const unsigned int MaxShortVertices = 65536;
+
+    GeometryArena(size_t stride, const std::vector<VertexAttribute> &attributes,
+                  size_t initialVertices, size_t initialIndexSlots);
+    ~GeometryArena();
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    // Stores the mesh as one range, with 16 bit indices when it has few enough vertices.
+    // A mesh without indices gets an empty range.
+    GeometryRange Allocate(const void *vertices, unsigned int vertexCount,
+                           const unsigned int *indices, unsigned int indexCount);
+    // Same, but meshes over MaxShortVertices are split into ranges that all fit 16 bit indices
+    std::vector<GeometryRange> AllocateSplit(const void *vertices, unsigned int vertexCount,
+                                             const unsigned int *indices, unsigned int indexCount);
+    void Free(const GeometryRange &range);
+
+    // Binds the arena buffers and points the format's attributes at them on the currently bound VAO
+    void SetupVertexAttributes();
+
+    void Bind();
+    // Expects the arena to be bound
+    void Draw(const GeometryRange &range);
+
+    unsigned int Generation() const { return generation; }
+    // Bytes of index data currently stored
+    size_t IndexBytes() const { return indexBytes; }
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef IMAGE_DECODE_POOL_H
+#define IMAGE_DECODE_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Pixels of a decoded file, owned by the pool and freed after the upload callback returns.
+// A callback that needs them longer takes them by setting pixels to null and later
+// releases them with ImageDecodePool::FreePixels.
+struct DecodedImage
+{
+    std::string path;
+    int width, height, channels;
+    // null when the file could not be decoded
+    unsigned char *pixels;
+    double decodeSeconds;
+};
+
+typedef std::function<void(DecodedImage &image)> ImageUpload;
+
+// Decodes image files with stb_image on worker threads. The upload callbacks only ever
+// run on the thread calling Poll or Finish (the GL thread), one per image in the order
+// the decodes complete, so the GL work overlaps with the decoding of the next files.
+// All stbi_load calls should go through here: stb_image's flip flag is global, the pool
+// leaves it off and flips the rows itself when asked to.
+class ImageDecodePool
+{
+public:
+    // 0 uses one thread per core
+    ImageDecodePool(unsigned int threadCount = 0);
+    ~ImageDecodePool();
+
+    ImageDecodePool(const ImageDecodePool&) = delete;
+    ImageDecodePool& operator=(const ImageDecodePool&) = delete;
+
+    // The pool every texture loader shares
+    static ImageDecodePool& Shared();
+
+    // Queues path, upload runs on the GL thread once it is decoded. halvings box filters the
+    // image down that many times on the worker, for a mip level other than 0.
+    void Decode(const std::string &path, bool flipVertically, ImageUpload upload, unsigned int halvings = 0);
+    // Runs the uploads of the images decoded so far, returns how many are still pending
+    unsigned int Poll();
+    // Waits for every queued image and runs its upload
+    void Finish();
+
+    unsigned int ThreadCount() const { return workers.size(); }
+    unsigned int DecodedCount() const { return decoded; }
+    // summed over the workers, compare with the wall time to see the speedup
+    double DecodeSeconds() const { return decodeSeconds; }
+
+    // For pixels an upload callback took over
+    static void FreePixels(unsigned char *pixels);
+
+    // Logs every image as it is uploaded
+    static bool Verbose;
+
+private:
+    struct Job
+    {
+        std::string path;
+        bool flipVertically;
+        unsigned int halvings;
+        ImageUpload upload;
+    };
+    struct Result
+    {
+        DecodedImage image;
+        ImageUpload upload;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable jobReady, resultReady;
+    std::deque<Job> jobs;
+    std::deque<Result> results;
+    // queued and not uploaded yet
+    unsigned int pending;
+    bool stopping;
+
+    unsigned int decoded;
+    double decodeSeconds;
+
+    void work();
+    void upload(Result &result);
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef INDIRECT_MODEL_H
+#define INDIRECT_MODEL_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+#include <Culling.hpp>
+#include <RenderQueue.hpp>
+#include <StreamBuffer.hpp>
+#include <TextureArray.hpp>
+
+#include <memory>
+#include <vector>
+
+// Shader storage binding points, a separate namespace from the uniform block bindings
+enum StorageBinding {
+    DrawDataBinding = 0,
+    InstanceDataBinding = 1,
+    InstanceIndexBinding = 2
+};
+
+// Layout of glMultiDrawElementsIndirect commands
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// std430 mirror of DrawData in backpack_indirect.vs, one per command
+struct IndirectDrawData
+{
+    glm::vec4 positionOffset;
+    glm::vec4 positionScale;
+    // offset in xy, scale in zw
+    glm::vec4 texCoordTransform;
+    int diffuseLayer;
+    int specularLayer;
+    float shininess;
+    float padding;
+};
+
+static_assert(sizeof(IndirectDrawData) == 64, "IndirectDrawData does not match std430");
+
+// Draws every mesh of a model, for any number of instances, with one glMultiDrawElementsIndirect.
+// Meshes already share MeshArena, so each range becomes a command, the per-mesh uniforms move
+// into a storage buffer indexed by gl_DrawIDARB and the textures into one array per slot,
+// indexed by a layer from the same buffer. Instance matrices go to the frame's stream buffer.
+// Meshes are culled per instance: each command draws only the instances its mesh is visible
+// in, listed in an instance index buffer that is rebuilt every frame.
+// Without GLExtensions::HasMultiDrawIndirect the same commands are looped over on the CPU
+// with the shader built without INDIRECT_DRAW, which reads the same data from uniforms.
+class IndirectModel
+{
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<IndirectDrawData> draws;
+    std::vector<glm::mat4> instances;
+    // mesh of each command, more than one command per mesh if it was split
+    std::vector<unsigned int> commandMesh;
+    std::vector<BoundingSphere> meshBounds;
+    // one flag per instance and mesh
+    std::vector<unsigned char> visibility;
+    // per command where its instances start, then the visible instances of each command
+    std::vector<GLuint> instanceIndices;
+    std::unique_ptr<TextureArray> diffuseTextures, specularTextures;
+    BoundingSphere bounds;
+    bool doubleSided;
+
+    StreamBuffer &stream;
+    unsigned int commandBuffer, drawBuffer;
+    // the instance counts in commands changed since the command buffer was written
+    bool commandsDirty;
+    // this frame's instance matrices and indices in stream, valid when instanceBytes is not 0
+    size_t instanceOffset, instanceBytes, indexOffset, indexBytes;
+    unsigned int drawCalls, visibleDraws;
+    // a streamed texture replaced its layer since the mip levels were generated
+    bool mipmapsDirty;
+
+    // uniforms of the fallback path, resolved per program
+    unsigned int handlesProgram;
+    UniformHandle modelHandle, positionOffsetHandle, positionScaleHandle, texCoordTransformHandle;
+    UniformHandle diffuseLayerHandle, specularLayerHandle, shininessHandle;
+
+    Shader *queuedShader;
+
+    void buildTextures(const std::vector<Mesh> &meshes, std::vector<int> &diffuseLayers,
+                       std::vector<int> &specularLayers);
+    // Sets the instance count of every command and lists its instances
+    void compact();
+    void drawIndirect();
+    void drawFallback(Shader &shader);
+    // RenderQueue callback, draws every instance
+    static void drawPacket(void *object, unsigned int first, unsigned int count);
+public:
+    // Largest texture array layer, larger sources are scaled down
+    static const GLsizei MaxLayerSize = 2048;
+
+    IndirectModel(const std::vector<Mesh> &meshes, StreamBuffer &stream, bool doubleSided = false);
+    ~IndirectModel();
+
+    IndirectModel(const IndirectModel&) = delete;
+    IndirectModel& operator=(const IndirectModel&) = delete;
+
+    // Points the diffuseTextures and specularTextures samplers at their units, once per program link
+    static void SetupSamplers(Shader &shader);
+
+    // Instances of the next draw, one model matrix each
+    void Begin();
+    // visible, if given, holds one flag per mesh as AddBounds added them, an instance with no visible mesh is skipped
+    void AddInstance(const glm::mat4 &model, const unsigned char *visible = nullptr);
+    // Writes the instances to the stream buffer, before it is committed
+    void Upload();
+
+    // Expects Upload since the last Begin
+    void Draw(Shader &shader);
+    // Uploads and queues all instances as one opaque packet, depth is the nearest instance
+    void Queue(RenderQueue &queue, Shader &shader, const glm::vec3 &cameraPosition);
+
+    // Adds the world space bounds of every mesh to the culling stage, returns the index of the first one
+    size_t AddBounds(CullingStage &culling, const glm::mat4 &model) const;
+
+    // Model space sphere around every mesh
+    const BoundingSphere& Bounds() const { return bounds; }
+    unsigned int MeshCount() const { return meshBounds.size(); }
+    unsigned int CommandCount() const { return commands.size(); }
+    unsigned int InstanceCount() const { return instances.size(); }
+    // commands times the instances each one draws, as of the last Upload
+    unsigned int VisibleDraws() const { return visibleDraws; }
+    // GL draw calls issued by the last draw, 1 on the indirect path
+    unsigned int DrawCalls() const { return drawCalls; }
+};
+
+#endif
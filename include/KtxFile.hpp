@@ -0,0 +1,48 @@
+#ifndef KTX_FILE_H
+#define KTX_FILE_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+// KTX 1.1 container (https://registry.khronos.org/KTX/specs/1.0/ktxspec.v1.html) holding
+// block-compressed 2D textures or cube maps with their mip chain. Only the subset the
+// asset baker writes is supported: native endianness, no array layers, no depth. Of the
+// key/value data only KTXorientation is read and written.
+class KtxFile
+{
+public:
+    // Which way the rows run: Up when the first row is the bottom of the image (baked with
+    // --flip, as loaders that flip expect), Down when it is the top, Unknown without the key
+    enum Orientation { OrientationUnknown, OrientationDown, OrientationUp };
+
+    GLenum internalFormat = 0;
+    // GL_RGBA when the image has alpha, GL_RGB when it is opaque whatever the block format
+    GLenum baseInternalFormat = 0;
+    unsigned int width = 0, height = 0;
+    // 1, or 6 for a cube map in +X, -X, +Y, -Y, +Z, -Z order
+    unsigned int faces = 1;
+    Orientation orientation = OrientationUnknown;
+    // data[level][face], level 0 is the full size
+    std::vector<std::vector<std::vector<unsigned char>>> data;
+
+    // Returns false and leaves the file empty if path is missing or not in the supported subset.
+    // With headerOnly only the format, size and orientation are read and data stays empty.
+    bool Read(const std::string &path, bool headerOnly = false);
+    bool Write(const std::string &path) const;
+
+    unsigned int Levels() const { return data.size(); }
+    unsigned int LevelWidth(unsigned int level) const { return width >> level ? width >> level : 1; }
+    unsigned int LevelHeight(unsigned int level) const { return height >> level ? height >> level : 1; }
+    // Bytes of one face of level
+    size_t LevelSize(unsigned int level) const;
+
+    // Bytes of a 4x4 block, 0 for formats outside the supported subset
+    static size_t BlockBytes(GLenum internalFormat);
+
+    // Where the baked version of an image is looked up: the same path with a .ktx extension
+    static std::string BakedPath(const std::string &imagePath);
+};
+
+#endif
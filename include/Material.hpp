@@ -0,0 +1,39 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <string>
+
+// Texture kinds a material can have, a mesh keeps the first texture of each
+enum TextureSlot {
+    DiffuseSlot,
+    SpecularSlot,
+    NormalSlot,
+    HeightSlot,
+    TextureSlotCount
+};
+
+// Slot of an assimp texture type name such as "texture_diffuse", TextureSlotCount if unknown
+TextureSlot textureSlotOf(const std::string &type);
+
+// The textures by slot and shading parameters of a mesh, resolved once when the model loads.
+// IndirectModel gathers them into its texture arrays and per-draw data, so a material owns no
+// GL objects of its own and stays a plain value like Mesh.
+class Material
+{
+public:
+    Material();
+
+    // First texture of a slot wins, the shaders only sample one per slot
+    void SetTexture(TextureSlot slot, unsigned int texture);
+    void SetShininess(float shininess);
+
+    // 0 when the slot is empty
+    unsigned int TextureOf(TextureSlot slot) const { return textures[slot]; }
+    float Shininess() const { return shininess; }
+
+private:
+    unsigned int textures[TextureSlotCount];
+    float shininess;
+};
+
+#endif
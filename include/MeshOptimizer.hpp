@@ -0,0 +1,123 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+#include <common.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Post-transform vertex cache behaviour of an index buffer, measured with a FIFO cache.
+// ACMR: vertex shader invocations per triangle. ATVR: invocations per vertex, 1 is optimal.
+struct VertexCacheStats
+{
+    float acmr;
+    float atvr;
+};
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                    unsigned int cacheSize = 16);
+
+// Reorders triangles for the post-transform cache (Forsyth's linear-speed optimizer)
+void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount);
+
+// Reorders the clusters of an already cache-optimized index buffer so outward facing
+// clusters far from the center are drawn first. Clusters are split where the cache
+// restarts, so the cache efficiency is preserved.
+void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<glm::vec3> &positions);
+
+void printOptimizationReport(const std::string &name, size_t vertexCountBefore, size_t vertexCountAfter,
+                             const VertexCacheStats &before, const VertexCacheStats &after);
+
+// Merges bitwise identical vertices. Returns the number of vertices removed.
+template <typename V>
+size_t deduplicateVertices(std::vector<V> &vertices, std::vector<unsigned int> &indices)
+{
+    const unsigned int empty = ~0u;
+
+    size_t tableSize = 1;
+    while(tableSize < vertices.size() * 2) {
+        tableSize <<= 1;
+    }
+
+    // open addressing table of indices into unique
+    std::vector<unsigned int> table(tableSize, empty);
+    std::vector<unsigned int> remap(vertices.size());
+    std::vector<V> unique;
+    unique.reserve(vertices.size());
+
+    for(size_t i = 0; i < vertices.size(); ++i) {
+        size_t slot = hashBytes(&vertices[i], sizeof(V)) & (tableSize - 1);
+        while(table[slot] != empty && std::memcmp(&unique[table[slot]], &vertices[i], sizeof(V)) != 0) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        if(table[slot] == empty) {
+            table[slot] = unique.size();
+            unique.push_back(vertices[i]);
+        }
+        remap[i] = table[slot];
+    }
+
+    for(unsigned int &index : indices) {
+        index = remap[index];
+    }
+
+    const size_t removed = vertices.size() - unique.size();
+    vertices.swap(unique);
+    return removed;
+}
+
+// Orders vertices by first use in the index buffer and drops unreferenced ones
+template <typename V>
+void optimizeVertexFetch(std::vector<V> &vertices, std::vector<unsigned int> &indices)
+{
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), unused);
+    std::vector<V> ordered;
+    ordered.reserve(vertices.size());
+
+    for(unsigned int &index : indices) {
+        if(remap[index] == unused) {
+            remap[index] = ordered.size();
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices.swap(ordered);
+}
+
+// Full pipeline for imported meshes: deduplication, vertex cache, overdraw and vertex fetch.
+// positionOf(const V&) returns the vertex position used for overdraw ordering.
+template <typename V, typename PositionOf>
+void optimizeMesh(const std::string &name, std::vector<V> &vertices, std::vector<unsigned int> &indices,
+                  PositionOf positionOf)
+{
+    if(indices.empty()) {
+        return;
+    }
+
+    const size_t vertexCountBefore = vertices.size();
+    const VertexCacheStats before = analyzeVertexCache(indices, vertices.size());
+
+    deduplicateVertices(vertices, indices);
+    optimizeVertexCache(indices, vertices.size());
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(vertices.size());
+    for(const V &v : vertices) {
+        positions.push_back(positionOf(v));
+    }
+    optimizeOverdraw(indices, positions);
+
+    optimizeVertexFetch(vertices, indices);
+
+    const VertexCacheStats after = analyzeVertexCache(indices, vertices.size());
+    printOptimizationReport(name, vertexCountBefore, vertices.size(), before, after);
+}
+
+#endif
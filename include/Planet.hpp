@@ -12,30 +12,46 @@
 
 #include <stb_image.h>
 
+#include <SphereCache.hpp>
+
+#include <memory>
 #include <vector>
 #include <string>
 
+// Per-planet GPU state is just the texture, the sphere LODs are shared through SphereCache
 class PlanetModel
 {
-    std::vector<float> data;
-    std::vector<unsigned int> indices;
+    SphereLodChain lods;
     std::string texturePath;
-    unsigned int VBO, VAO, EBO, texture;
+    // a TextureRegistry reference, copies take one of their own
+    unsigned int texture;
 
-    void generateVertexData();
-    void setupBuffers();
+    void setupTexture();
 public:
+    // Radius the unit spheres are scaled to, shaders take it as the sphereRadius uniform
+    static const float SphereRadius;
 
-    void draw();
+    void draw(int level = 0);
 
     PlanetModel(const std::string texturePath = "")
-    :   texturePath(texturePath)
+    :   lods(),
+        texturePath(texturePath),
+        texture(0)
     {
-        this->generateVertexData();
-        this->setupBuffers();
+        this->setupTexture();
     }
 
+    PlanetModel(const PlanetModel &other);
+    PlanetModel& operator=(const PlanetModel &other);
+    ~PlanetModel();
+
     bool hasTexture() { return texturePath != ""; }
+    unsigned int getTexture() const { return texture; }
+    // Drops the texture, for planets only drawn from a PlanetRenderer layer that no longer reads it
+    void releaseTexture();
+    // the texture has an alpha channel, drawn in the transparent pass. Not known while it streams.
+    bool isTranslucent() const;
+    const SphereLodChain& getLods() const { return lods; }
 
 
 };
@@ -0,0 +1,110 @@
+#ifndef PLANET_RENDERER_H
+#define PLANET_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <ShaderPermutations.hpp>
+#include <RenderQueue.hpp>
+#include <SphereCache.hpp>
+#include <StreamBuffer.hpp>
+#include <TextureArray.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Per-instance attributes, laid out exactly as the instance buffer expects them
+struct PlanetInstance
+{
+    glm::mat4 model;
+    glm::vec3 normalMatrix[3];
+    float scale;
+    float layer;
+    // Sort key only, not read by the shader
+    int lod;
+};
+
+// Collects every planet submitted during a frame and queues them as
+// glDrawElementsInstancedBaseVertex packets, one per LOD instead of one per body.
+// Every planet texture goes into one layer of a texture array and the layer is instance data,
+// so textured bodies batch together whatever their texture, and a new body costs a layer
+// upload instead of a draw call. When every planet map was baked at the layer size the array
+// keeps their block-compressed levels, otherwise the textures are resampled into RGBA8 layers.
+// The array is what is drawn, so it is what the ResidencyManager budgets: its layers are dropped
+// together and brought back at the level the closest body needs, compressed ones read from their
+// KTX, RGBA8 ones copied again from their sources, which are requested along with the array.
+// Textured and untextured groups use their own shader variant. Bodies with a translucent texture are queued one by one in the transparent
+// pass so they can be sorted by depth.
+class PlanetRenderer
+{
+    SphereLodChain lods;
+    StreamBuffer &stream;
+    unsigned int VAO;
+    // where this frame's instances were written in stream
+    size_t instanceOffset;
+    unsigned int arenaGeneration;
+    std::vector<PlanetInstance> instances;
+    TextureArray layers;
+    // layers were added since the mip levels were last generated
+    bool mipmapsDirty;
+    std::vector<bool> layerTranslucent;
+    // finest level of its texture each layer was copied from
+    std::vector<int> layerLevel;
+    std::map<unsigned int, int> layerOfTexture;
+    // compressed layers by baked path, their textures may be released once the layer is read
+    std::map<std::string, int> layerOfBake;
+    // texture each RGBA8 layer is copied from
+    std::vector<unsigned int> layerSource;
+    // the array as the ResidencyManager knows it, Id changes when it grows
+    unsigned int trackedLayers;
+    unsigned int promotionListener;
+    unsigned int drawCalls;
+    unsigned int levelInstances[SphereLodChain::LevelCount];
+
+    ShaderPermutations *queuedShaders;
+
+    void setupBuffers();
+    // Hands the current array to the ResidencyManager
+    void trackLayers();
+    void bindInstanceAttributes(size_t firstInstance);
+    enum InstanceGroup { UntexturedGroup, TexturedGroup, TranslucentGroup };
+    int groupOf(const PlanetInstance &instance) const;
+    static float depthOf(const PlanetInstance &instance, const glm::vec3 &cameraPosition);
+    // RenderQueue callback, draws instances first..first+count, which share LOD and layer
+    static void drawPacket(void *object, unsigned int first, unsigned int count);
+public:
+    // Size every planet texture is resampled to, equirectangular maps are 2:1
+    static const GLsizei LayerWidth = 2048, LayerHeight = 1024;
+
+    // The layer format for a set of planet textures: the compressed format they were all baked in
+    // at the layer size, GL_RGBA8 if any of them was not
+    static GLenum LayerFormatOf(const std::vector<std::string> &texturePaths);
+
+    // Instances are written to stream every frame, layerFormat comes from LayerFormatOf
+    PlanetRenderer(const SphereLodChain &lods, StreamBuffer &stream, GLenum layerFormat = GL_RGBA8);
+    ~PlanetRenderer();
+
+    PlanetRenderer(const PlanetRenderer&) = delete;
+    PlanetRenderer& operator=(const PlanetRenderer&) = delete;
+
+    // Returns the layer a texture loaded from texturePath is drawn from, -1 for untextured bodies.
+    // Compressed layers are read from its baked KTX, RGBA8 ones are copied from the texture.
+    int AddTexture(unsigned int textureId, const std::string &texturePath, bool translucent = false);
+
+    // A body drawn from layer covers screenPixels texels of its width this frame, for the ResidencyManager
+    void RequestLayer(int layer, float screenPixels);
+    bool CompressedLayers() const { return layers.Compressed(); }
+
+    void Begin();
+    void Submit(const glm::mat4 &model, const glm::mat3 &normalMatrix, float scale, int layer, int lod);
+    // Writes the instances to the stream buffer and queues their draws, they must stay untouched until the queue executes
+    void Queue(RenderQueue &queue, ShaderPermutations &shaders, const glm::vec3 &cameraPosition);
+
+    unsigned int DrawCalls() const { return drawCalls; }
+    unsigned int InstanceCount() const { return instances.size(); }
+    unsigned int LevelInstanceCount(int level) const { return levelInstances[level]; }
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <string>
+#include <vector>
+
+// Stores linked programs on disk with glGetProgramBinary and restores them with
+// glProgramBinary, so later runs skip compiling and linking. Entries are keyed by
+// the shader sources and the driver strings, a changed shader or driver just misses.
+// Does nothing when the driver has no program binary formats.
+// Edited shaders leave entries nobody loads again: a reloaded program removes the entry of
+// the sources it replaces, and every Store trims the directory to MaxBytes, least recently
+// used entries first.
+class ProgramCache
+{
+public:
+    static std::string Directory;
+    static const size_t MaxBytes = 32 << 20;
+    // Off skips both loading and storing, for measuring real compiles
+    static bool Enabled;
+
+    // Key of a program built from the given sources (defines are part of the source text)
+    static std::string Key(const std::vector<std::string> &sources);
+
+    // Loads the cached binary into program, false when it is missing or rejected
+    static bool Load(unsigned int program, const std::string &key);
+    // Writes the binary of a successfully linked program
+    static void Store(unsigned int program, const std::string &key);
+    // Deletes the entry of key, for a program whose sources changed
+    static void Remove(const std::string &key);
+    // Must be set before linking a program that will be stored
+    static void MarkRetrievable(unsigned int program);
+
+    static unsigned int Hits() { return hits; }
+    static unsigned int Misses() { return misses; }
+
+private:
+    static unsigned int hits, misses;
+
+    static std::string path(const std::string &key);
+    // Deletes the least recently used entries until the directory fits in MaxBytes
+    static void prune();
+};
+
+#endif
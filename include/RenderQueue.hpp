@@ -0,0 +1,78 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Passes run in this order, each one sets its own blend and depth write state
+enum RenderPass {
+    BackgroundPass,
+    OpaquePass,
+    TransparentPass,
+    RenderPassCount
+};
+
+enum BlendMode {
+    BlendNone,
+    BlendAlpha
+};
+
+// Draws first..first+count of whatever object points to, the meaning is up to the submitter
+typedef void (*DrawFunction)(void *object, unsigned int first, unsigned int count);
+
+struct DrawPacket
+{
+    DrawFunction draw;
+    void *object;
+    unsigned int first;
+    unsigned int count;
+};
+
+// Collects the draws of a frame with a 64-bit sort key each, radix sorts them and runs
+// them in one go. Opaque keys are ordered by state first and then front to back for
+// early-Z, transparent keys by depth back to front so blending composes correctly:
+//
+//   opaque:      pass:2 | blend:2 | program:12 | material:24 | depth:24
+//   transparent: pass:2 | far-to-near depth:24 | blend:2 | program:12 | material:24
+class RenderQueue
+{
+public:
+    // farDistance maps to the largest depth value, anything beyond it is clamped
+    void Begin(float farDistance);
+
+    static uint64_t MakeKey(RenderPass pass, BlendMode blend, unsigned int program, unsigned int material,
+                            float depth, float farDistance);
+    // Key for the current frame's far distance
+    uint64_t Key(RenderPass pass, BlendMode blend, unsigned int program, unsigned int material, float depth) const
+    {
+        return MakeKey(pass, blend, program, material, depth, farDistance);
+    }
+
+    void Submit(uint64_t key, DrawFunction draw, void *object, unsigned int first = 0, unsigned int count = 1);
+
+    // Sorts and draws everything submitted since Begin
+    void Execute();
+
+    size_t PacketCount() const { return packets.size(); }
+    size_t PassPacketCount(RenderPass pass) const { return passPackets[pass]; }
+
+private:
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t packet;
+    };
+
+    float farDistance = 1.0f;
+    std::vector<DrawPacket> packets;
+    std::vector<SortEntry> entries, scratch;
+    size_t passPackets[RenderPassCount] = {};
+
+    void sort();
+    static void setPassState(RenderPass pass);
+};
+
+#endif
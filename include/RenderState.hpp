@@ -0,0 +1,82 @@
+#ifndef RENDER_STATE_H
+#define RENDER_STATE_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// Shadows the GL state touched by the renderer and only issues a call when the
+// state actually changes. All binds of programs, VAOs and textures and all
+// blend/cull/depth switches should go through it, otherwise the shadow goes stale.
+class RenderState
+{
+public:
+    static const unsigned int MaxTextureUnits = 16;
+    static const unsigned int MaxUniformBindings = 8;
+
+    // Forgets the shadowed state, the next call of every kind is issued.
+    // Needed once at startup and after code that changes state without restoring it.
+    static void Invalidate();
+    // Resets the per-frame counters
+    static void BeginFrame();
+
+    static void UseProgram(unsigned int program);
+    static void BindVertexArray(unsigned int vao);
+    static void BindTexture(unsigned int unit, GLenum target, unsigned int texture);
+    // glBindBufferBase on GL_UNIFORM_BUFFER, also leaves the buffer bound to the generic target
+    static void BindUniformBuffer(unsigned int binding, unsigned int buffer);
+    // glBindBufferRange on GL_UNIFORM_BUFFER, offset must be a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    static void BindUniformBufferRange(unsigned int binding, unsigned int buffer, size_t offset, size_t size);
+
+    static void SetBlend(bool enabled);
+    static void SetBlendFunc(GLenum source, GLenum destination);
+    static void SetCullFace(bool enabled, GLenum mode = GL_BACK);
+    static void SetDepthTest(bool enabled);
+    static void SetDepthMask(bool enabled);
+    static void SetViewport(int x, int y, int width, int height);
+
+    // The blend, cull and depth switches and the viewport as shadowed, for passes that change them
+    // and have to put them back. What was unknown when saved is unknown again after Restore.
+    struct Saved
+    {
+        int blend, cullFace, depthTest;
+        int viewport[4];
+    };
+    static Saved Save();
+    static void Restore(const Saved &saved);
+
+    // Must be called before deleting objects, GL unbinds them and the name may be reused
+    static void ForgetProgram(unsigned int id);
+    static void ForgetVertexArray(unsigned int vao);
+    static void ForgetTexture(unsigned int texture);
+
+    static unsigned int CallsIssued() { return issued; }
+    static unsigned int CallsSkipped() { return skipped; }
+
+private:
+    enum TextureTarget { Texture2D, TextureCubeMap, Texture2DArray, TextureTargetCount };
+
+    // Values no real state has, used for "unknown"
+    static const unsigned int Unknown = ~0u;
+
+    static unsigned int program;
+    static unsigned int vertexArray;
+    static unsigned int activeUnit;
+    static unsigned int textures[MaxTextureUnits][TextureTargetCount];
+    static unsigned int uniformBuffers[MaxUniformBindings];
+    // the whole buffer is bound when the size is 0
+    static size_t uniformOffsets[MaxUniformBindings], uniformSizes[MaxUniformBindings];
+    static int blend, cullFace, depthTest, depthMask;
+    // width -1 when unknown
+    static int viewport[4];
+    static GLenum blendSource, blendDestination, cullMode;
+
+    static unsigned int issued, skipped;
+
+    static int targetIndex(GLenum target);
+    static void setCapability(GLenum capability, int &shadow, bool enabled);
+    // Counts the call and returns whether it has to be issued
+    static bool changed(bool differs);
+};
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef RESIDENCY_MANAGER_H
+#define RESIDENCY_MANAGER_H
+
+#include <glad/glad.h>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Runs on the GL thread once finer mip levels of a texture are in
+typedef std::function<void(unsigned int texture)> TexturePromoted;
+// Respecifies and fills levels first..last-1 of a texture whose owner knows where they come
+// from, false if it could not
+typedef std::function<bool(int first, int last)> TextureLevelLoader;
+
+// Keeps the mip levels of every loaded texture in memory only as far as the screen needs them.
+// GL 3.3 has no sparse textures, so a texture's residency is its finest level: levels finer
+// than GL_TEXTURE_BASE_LEVEL are respecified as 0x0, which lets the driver free them, and
+// loaded again from the source image (through TextureStreamer::Reload), the baked KTX or the
+// owner's loader (for texture arrays filled from several files) when the texture is needed
+// at that size.
+//
+// Drawing code calls Request with how many texels wide the texture is seen each frame, the
+// manager wants the level that is at least that wide. Textures that were never requested are
+// only counted, they may be drawn in ways the manager knows nothing about. When the resident
+// levels exceed the budget the least recently requested textures are dropped first, unseen ones
+// down to EvictSize, and textures are only promoted while the budget has room for them.
+class ResidencyManager
+{
+public:
+    static const size_t DefaultBudget = 256 << 20;
+    // largest side an unseen texture keeps when it is evicted
+    static const int EvictSize = 64;
+    // textures whose finer levels are loaded per Update, each is a decode or a KTX read
+    static const unsigned int PromotionsPerFrame = 2;
+
+    // Never destroyed, textures may be untracked while the program exits
+    static ResidencyManager& Shared();
+
+    // Registers a complete or still streaming texture with its full mip chain. sources are the
+    // image (the six faces of a cube map) it was decoded from, bakedPath the KTX it was read
+    // from, empty when it was decoded.
+    void Track(unsigned int texture, GLenum target, const std::vector<std::string> &sources,
+               const std::string &bakedPath, bool flipVertically);
+    // Registers a complete texture, a 2D one or an array, whose dropped levels load brings back
+    void Track(unsigned int texture, GLenum target, TextureLevelLoader load);
+    // The texture is about to be deleted
+    void Untrack(unsigned int texture);
+    // The texture is drawn this frame covering screenPixels texels of its width
+    void Request(unsigned int texture, float screenPixels);
+    // Once per frame on the GL thread, after TextureStreamer::Update: drops and loads levels
+    void Update();
+
+    // The finest level in memory, 0 for a texture the manager does not know
+    int ResidentLevel(unsigned int texture) const;
+
+    // Runs listener whenever a texture gets finer levels, for copies of it that should be redone
+    unsigned int AddPromotionListener(TexturePromoted listener);
+    void RemovePromotionListener(unsigned int id);
+
+    void SetBudget(size_t bytes) { budget = bytes; }
+    size_t Budget() const { return budget; }
+    // every tracked level, as of the last Update
+    size_t ResidentBytes() const { return residentBytes; }
+    unsigned int PendingUploads() const { return promoting; }
+    // textures that had levels dropped
+    unsigned int Evictions() const { return evictions; }
+    unsigned int Promotions() const { return promotions; }
+
+private:
+    struct Entry
+    {
+        GLenum target;
+        std::vector<std::string> sources;
+        std::string bakedPath;
+        bool flipVertically;
+        TextureLevelLoader load;
+        // the size and format are read back once the texture is complete
+        bool known = false;
+        // complete with a regular mip chain from level 0, otherwise it is left alone
+        bool managed = false;
+        bool compressed = false;
+        GLenum internalFormat = 0;
+        int width = 0, height = 0, levels = 0;
+        // 6 for a cube map, the layers of an array
+        unsigned int faces = 1;
+        // finest level in memory
+        int resident = 0;
+        // level being loaded, -1 for none
+        int promotingTo = -1;
+        // widest request of the frame lastRequested
+        float screenPixels = 0.0f;
+        // 0 for never
+        unsigned long lastRequested = 0;
+    };
+
+    std::unordered_map<unsigned int, Entry> entries;
+    std::unordered_map<unsigned int, TexturePromoted> listeners;
+    unsigned int nextListener = 1;
+    // frames start at 1 so that 0 means never requested
+    unsigned long frame = 1;
+    size_t budget = DefaultBudget;
+    size_t residentBytes = 0;
+    unsigned int promoting = 0, evictions = 0, promotions = 0;
+
+    ResidencyManager() = default;
+    // Reads the size and format of a complete texture
+    void learn(unsigned int texture, Entry &entry);
+    static size_t levelBytes(const Entry &entry, int level);
+    // Bytes of levels first..last-1
+    static size_t levelRangeBytes(const Entry &entry, int first, int last);
+    // Level at least screenPixels wide
+    static int wantedLevel(const Entry &entry);
+    static int evictLevel(const Entry &entry);
+    // Drops the levels finer than level
+    void demote(unsigned int texture, Entry &entry, int level);
+    // Starts loading levels level..resident-1, false if it could not
+    bool promote(unsigned int texture, Entry &entry, int level);
+    void promoted(unsigned int texture, int level);
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SHADER_BUILD_QUEUE_H
+#define SHADER_BUILD_QUEUE_H
+
+#include <learnopengl/shader.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Builds many programs without stalling on each one. Sources are read on worker
+// threads as soon as a program is added, Submit issues every compile and link up
+// front, and a program only blocks the first time it is used (or in Finish).
+// With KHR_parallel_shader_compile the driver compiles them on its own threads
+// and Poll can tell which ones are done without waiting.
+class ShaderBuildQueue
+{
+public:
+    ShaderBuildQueue() = default;
+    ShaderBuildQueue(const ShaderBuildQueue&) = delete;
+    ShaderBuildQueue& operator=(const ShaderBuildQueue&) = delete;
+
+    // The shader stays valid as long as the queue, it can be used before it is built
+    Shader& Add(const std::string &vertexPath, const std::string &fragmentPath,
+                const std::vector<std::string> &defines = {});
+
+    // Starts compiling everything added since the last Submit
+    void Submit();
+    // Finishes the programs that are done, returns how many are still compiling
+    unsigned int Poll();
+    // Waits for every program
+    void Finish();
+
+    size_t Size() const { return shaders.size(); }
+
+private:
+    std::vector<std::unique_ptr<Shader>> shaders;
+    size_t submitted = 0;
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SHADER_HOT_RELOAD_H
+#define SHADER_HOT_RELOAD_H
+
+#include <string>
+
+// Watches a shader directory with inotify and rebuilds every live Shader that uses a
+// changed file. Rebuilds run in the background, a program is swapped in once its
+// replacement has linked, and one that fails to compile keeps the old program running.
+// Does nothing where inotify is not available.
+class ShaderHotReload
+{
+public:
+    explicit ShaderHotReload(const std::string &directory);
+    ~ShaderHotReload();
+
+    ShaderHotReload(const ShaderHotReload&) = delete;
+    ShaderHotReload& operator=(const ShaderHotReload&) = delete;
+
+    // Once per frame, never waits for the compiler or the file system
+    void Update();
+
+    bool IsWatching() const { return watchDescriptor >= 0; }
+    unsigned int ReloadCount() const { return reloads; }
+
+private:
+    std::string directory;
+    int inotifyDescriptor, watchDescriptor;
+    unsigned int reloads;
+
+    void fileChanged(const std::string &name);
+};
+
+#endif
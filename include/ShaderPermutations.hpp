@@ -0,0 +1,54 @@
+#ifndef SHADER_PERMUTATIONS_H
+#define SHADER_PERMUTATIONS_H
+
+#include <learnopengl/shader.h>
+#include <ShaderBuildQueue.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Material features a shader can be specialized for, one bit each
+enum ShaderFeature : unsigned int {
+    FeatureTexture = 1u << 0
+};
+
+// #define injected for each ShaderFeature bit, in bit order
+const std::vector<std::string>& ShaderFeatureDefines();
+
+// One vertex/fragment pair compiled once per combination of features. Each
+// feature becomes a #define, so every variant runs straight-line code instead of
+// branching on a uniform. Variants are built the first time they are asked for,
+// or ahead of time through a ShaderBuildQueue.
+class ShaderPermutations
+{
+public:
+    ShaderPermutations(const std::string &vertexPath, const std::string &fragmentPath);
+
+    ShaderPermutations(const ShaderPermutations&) = delete;
+    ShaderPermutations& operator=(const ShaderPermutations&) = delete;
+
+    // Runs on every variant after it links (again after a hot reload), for uniforms that never change
+    void SetInitializer(std::function<void(Shader&)> initializer);
+
+    // Builds a variant through the queue so it compiles with the others, the queue owns it
+    // and must outlive this object
+    void Prefetch(unsigned int features, ShaderBuildQueue &queue);
+
+    Shader& Get(unsigned int features);
+
+    size_t VariantCount() const { return variants.size(); }
+
+private:
+    std::string vertexPath, fragmentPath;
+    std::function<void(Shader&)> initializer;
+    std::unordered_map<unsigned int, Shader*> variants;
+    // variants built here rather than through a queue
+    std::vector<std::unique_ptr<Shader>> owned;
+
+    static std::vector<std::string> definesOf(unsigned int features);
+};
+
+#endif
@@ -8,12 +8,17 @@
 #include <GLFW//glfw3.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/shader.h>
+#include <RenderState.hpp>
+#include <RenderQueue.hpp>
 
 class Skybox
 {
     public:
-    unsigned int textureId;
+    // a TextureRegistry reference
+    unsigned int textureId = 0;
     unsigned int VAO, VBO;
+    // shader of the packet queued this frame
+    Shader *queuedShader = nullptr;
 
 
     Skybox()
@@ -68,13 +73,21 @@ class Skybox
         glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
 
         glGenVertexArrays(1, &VAO);
-        glBindVertexArray(VAO);
+        RenderState::BindVertexArray(VAO);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3*sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
     }
 
-    int Load(std::vector<std::string> &textureFaces);
-    void Draw(Camera &camera, Shader &shader);
+    // Loads bakedPath, a cube map KTX from asset_baker, when given and present, otherwise decodes the faces
+    int Load(std::vector<std::string> &textureFaces, const std::string &bakedPath = "");
+    ~Skybox();
+
+    Skybox(const Skybox&) = delete;
+    Skybox& operator=(const Skybox&) = delete;
+    // Uses the camera from the FrameData block
+    void Draw(Shader &shader);
+    // Queues the skybox in the background pass, behind everything else
+    void Queue(RenderQueue &queue, Shader &shader);
 };
 
 #endif
@@ -0,0 +1,71 @@
+#ifndef SPHERE_CACHE_H
+#define SPHERE_CACHE_H
+
+#include <glad/glad.h>
+
+#include <GeometryArena.hpp>
+#include <VertexPacking.hpp>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+// Tessellation parameters that uniquely describe a generated unit sphere
+struct SphereKey
+{
+    int latitudeSegments;
+    int longitudeSegments;
+
+    bool operator<(const SphereKey &o) const;
+};
+
+// GPU side of a generated sphere, a range of the planet geometry arena. Owned through
+// shared_ptr handed out by SphereCache, the range is released when the last user goes away.
+class SphereMesh
+{
+public:
+    GeometryRange range;
+
+    SphereMesh(const std::vector<PackedSphereVertex> &data, const std::vector<unsigned int> &indices);
+    ~SphereMesh();
+
+    SphereMesh(const SphereMesh&) = delete;
+    SphereMesh& operator=(const SphereMesh&) = delete;
+};
+
+// Unit spheres at decreasing tessellation, level 0 is the finest.
+// Copies are cheap, all levels are shared through SphereCache.
+class SphereLodChain
+{
+    std::vector<std::shared_ptr<SphereMesh>> levels;
+public:
+    static const int LevelCount = 6;
+    // Segments per level and the smallest projected radius in pixels each level is used for
+    static const int LevelSegments[LevelCount];
+    static const float LevelMinScreenRadius[LevelCount];
+    // Fraction a radius has to move past a level boundary before the level changes
+    static const float Hysteresis;
+
+    SphereLodChain();
+
+    const std::shared_ptr<SphereMesh>& Level(int level) const { return levels[level]; }
+
+    // Picks the level for a sphere covering screenRadius pixels, keeping current while
+    // the radius stays within the hysteresis band around its boundaries.
+    static int SelectLevel(float screenRadius, int current);
+};
+
+class SphereCache
+{
+    static std::map<SphereKey, std::weak_ptr<SphereMesh>> meshes;
+
+    static void generateVertexData(const SphereKey &key, std::vector<PackedSphereVertex> &data, std::vector<unsigned int> &indices);
+public:
+    // Arena holding every sphere as PackedSphereVertex
+    static GeometryArena& Arena();
+
+    // Returns the shared mesh for key, generating and uploading it on first use
+    static std::shared_ptr<SphereMesh> Get(const SphereKey &key);
+};
+
+#endif
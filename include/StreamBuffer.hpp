@@ -0,0 +1,71 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// Where an allocation lives, pointer is null when the frame's region is full
+struct StreamAllocation
+{
+    size_t offset;
+    void *pointer;
+};
+
+// Ring of FrameCount regions in one buffer for data written every frame (instances,
+// uniform blocks, ...). Each frame bump-allocates from its own region, which the GPU
+// stopped reading FrameCount frames ago, guarded by a fence, so writing never waits on
+// a buffer that is still in use and nothing is orphaned.
+// With GLExtensions::HasBufferStorage the buffer is mapped once, persistent and coherent.
+// Otherwise the free part of the region is mapped unsynchronized on the first Allocate
+// after a Commit, the fences make that safe too.
+class StreamBuffer
+{
+public:
+    static const unsigned int FrameCount = 3;
+
+    StreamBuffer(size_t frameBytes);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // Moves to the next region, waits only if the GPU is still FrameCount frames behind
+    void BeginFrame();
+    // offset is from the start of the buffer, alignment must be a power of two
+    StreamAllocation Allocate(size_t bytes, size_t alignment = 16);
+    // Makes the writes so far visible to GL, call before the draws that read them
+    void Commit();
+    // Fences the region, after the last draw that reads it
+    void EndFrame();
+
+    unsigned int Id() const { return buffer; }
+    bool IsPersistent() const { return persistent; }
+    size_t FrameBytes() const { return frameBytes; }
+    // bytes allocated this frame
+    size_t UsedBytes() const { return head; }
+    // frames that had to wait for the GPU
+    unsigned int Stalls() const { return stalls; }
+
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, for allocations bound as uniform blocks
+    static size_t UniformAlignment();
+    // GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, only meaningful with shader storage buffers
+    static size_t StorageAlignment();
+
+private:
+    unsigned int buffer;
+    bool persistent;
+    size_t frameBytes;
+    unsigned int frame;
+    size_t head;
+    GLsync fences[FrameCount];
+    // persistent: the whole buffer, otherwise the currently mapped part of the region
+    unsigned char *mapped;
+    size_t mappedOffset;
+    unsigned int stalls;
+    bool overflowReported;
+
+    size_t regionOffset() const { return frame * frameBytes; }
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+class Shader;
+
+// A GL_TEXTURE_2D_ARRAY with a full mip chain. A GL_RGBA8 array is filled by resampling
+// existing 2D textures into its layers on the GPU, so sources of any size and format
+// (compressed ones included) can share one binding. A block-compressed array is filled
+// with the levels of KTX files baked at its size and format, uploaded as they are, which
+// keeps the layers as small as the files.
+// It doubles its capacity when full, which replaces the texture, so Id can change on Add.
+class TextureArray
+{
+    unsigned int texture;
+    GLenum internalFormat;
+    // where each layer of a compressed array was read from, to fill a grown texture again
+    struct BakedLayer
+    {
+        std::string path;
+        bool flipVertically;
+    };
+    std::vector<BakedLayer> bakedLayers;
+    // what each layer of a GL_RGBA8 array was drawn from, a source texture or a color when it is 0
+    struct CopiedLayer
+    {
+        unsigned int source;
+        glm::vec4 color;
+    };
+    std::vector<CopiedLayer> copiedLayers;
+    unsigned int drawFramebuffer;
+    // empty, the copy shader makes its triangle from gl_VertexID
+    unsigned int copyVertexArray;
+    GLsizei width, height;
+    GLsizei capacity, layers;
+    GLsizei levels;
+
+    // Points the draw framebuffer at level of layer, leaves it bound
+    void bindLayer(GLsizei layer, GLsizei level);
+    // Resamples the source of layer into level, or clears it to its color
+    void fill(GLsizei layer, GLsizei level);
+    // The finest level in memory, levels above it may have been dropped by the ResidencyManager
+    GLsizei residentLevel() const;
+    // Uploads levels first..last-1 of a compressed layer from its KTX, false if the file does not match
+    bool loadLayer(GLsizei layer, const BakedLayer &baked, GLsizei first, GLsizei last);
+    // Creates a texture with room for capacity layers
+    static unsigned int allocate(GLsizei width, GLsizei height, GLsizei levels, GLsizei capacity,
+                                 GLenum internalFormat);
+    // Allocates one level of the bound array, its contents undefined
+    static void specifyLevel(GLsizei level, GLsizei width, GLsizei height, GLsizei capacity, GLenum internalFormat);
+    // Fills a texture twice as large with the layers again, the mip levels have to be generated again
+    void grow();
+    // Draws source over the bound draw framebuffer, loaded on first use and shared by all arrays
+    static Shader& copyShader();
+public:
+    // internalFormat is GL_RGBA8, or one of the S3TC formats KtxFile reads for arrays filled with AddBaked
+    TextureArray(GLsizei width, GLsizei height, GLsizei capacity, GLenum internalFormat = GL_RGBA8);
+    ~TextureArray();
+
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    // Scales source (a GL_TEXTURE_2D) into the next free layer and returns the layer, GL_RGBA8 only
+    int Add(unsigned int source);
+    // Copies source over an existing layer again, for sources whose image arrived later
+    void Replace(int layer, unsigned int source);
+    // Fills the next free layer with a single color, for missing textures, GL_RGBA8 only
+    int AddColor(const glm::vec4 &color);
+    // Rebuilds the mip levels from the finest resident level, call after the layers are added. Compressed layers come with theirs.
+    void GenerateMipmaps();
+
+    // Uploads every level of a KTX baked at the size and in the format of a compressed array into the
+    // next free layer, -1 if it is missing, does not match or was baked in the other orientation
+    int AddBaked(const std::string &bakedPath, bool flipVertically);
+    // Allocates levels first..last-1 again and fills them, for the ResidencyManager after it dropped them:
+    // compressed layers are read from their KTX, RGBA8 ones are copied from their sources at level first
+    // and the coarser levels generated from it
+    bool LoadLevels(GLsizei first, GLsizei last);
+
+    // Size of level 0 of a 2D texture
+    static glm::ivec2 SizeOf(unsigned int texture);
+    // The compressed format of the KTX baked for an image if it is width x height in the orientation
+    // asked for, GL_RGBA8 if there is none, reading only its header
+    static GLenum BakedFormatOf(const std::string &bakedPath, GLsizei width, GLsizei height, bool flipVertically);
+
+    unsigned int Id() const { return texture; }
+    GLenum InternalFormat() const { return internalFormat; }
+    bool Compressed() const { return internalFormat != GL_RGBA8; }
+    GLsizei Layers() const { return layers; }
+    GLsizei Capacity() const { return capacity; }
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// How a texture is loaded, part of the registry key: the same file loaded two ways is two textures
+enum TextureFlags
+{
+    TextureFlipVertically = 1 << 0,
+    TextureClampToEdge = 1 << 1,
+    TextureCubeMap = 1 << 2
+};
+
+// Every texture loaded from a file, shared process-wide. A file is looked up by its canonical
+// path and load flags in a hash map, so however many models, planets or skyboxes name it, it is
+// decoded and uploaded once. Each Acquire takes a reference and must be matched by a Release;
+// the GL texture is deleted with its last reference.
+// Textures come from a baked KTX next to the file when there is one, else from the TextureStreamer,
+// and the ResidencyManager tracks their mip levels from then on.
+class TextureRegistry
+{
+public:
+    // Never destroyed, textures may be released while the program exits
+    static TextureRegistry& Shared();
+
+    unsigned int Acquire(const std::string &path, unsigned int flags);
+    // faces in +X, -X, +Y, -Y, +Z, -Z order, bakedPath is tried first. Their placeholder is black.
+    unsigned int AcquireCubeMap(const std::vector<std::string> &faces, const std::string &bakedPath = "");
+    // Another reference to a texture already acquired, for copies of its owner
+    void AddRef(unsigned int texture);
+    void Release(unsigned int texture);
+
+    // Known once the image is in, false for a texture still streaming
+    bool HasAlpha(unsigned int texture) const;
+
+    unsigned int Count() const { return entries.size(); }
+    // Acquires that found the texture already loaded
+    unsigned int Hits() const { return hits; }
+    unsigned int Loads() const { return loads; }
+
+    // Resolves . and .. and symbolic links, files that do not exist are only normalized
+    static std::string CanonicalPath(const std::string &path);
+
+private:
+    struct Key
+    {
+        std::string path;
+        unsigned int flags;
+
+        bool operator==(const Key &other) const { return flags == other.flags && path == other.path; }
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const;
+    };
+    struct Entry
+    {
+        Key key;
+        unsigned int references;
+        bool hasAlpha;
+    };
+
+    std::unordered_map<Key, unsigned int, KeyHash> textureOf;
+    std::unordered_map<unsigned int, Entry> entries;
+    unsigned int hits = 0, loads = 0;
+
+    TextureRegistry() = default;
+    // Looks key up and takes a reference, or loads it with load and registers it
+    template <typename Load>
+    unsigned int acquire(const Key &key, Load load);
+};
+
+#endif
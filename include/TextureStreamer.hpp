@@ -0,0 +1,135 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+
+#include <ImageDecodePool.hpp>
+#include <StreamBuffer.hpp>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct TextureLoadOptions
+{
+    bool flipVertically = true;
+    GLenum wrap = GL_REPEAT;
+    // shown until the image is uploaded
+    unsigned char placeholder[4] = {128, 128, 128, 255};
+};
+
+// Runs on the GL thread once the image of a streamed texture is in place
+typedef std::function<void(unsigned int texture, bool hasAlpha)> TextureReady;
+
+// Creates textures without waiting for their images. Load returns a texture name right
+// away that samples as a 1x1 placeholder; the image is decoded on the shared
+// ImageDecodePool and Update copies its rows into a pixel unpack ring (a StreamBuffer)
+// and uploads them with glTexSubImage2D, at most FrameBudget bytes per frame.
+//
+// The name never changes: once the image is known, level 0 is allocated at full size
+// while GL_TEXTURE_BASE_LEVEL points at the smallest level, which holds the placeholder.
+// Rows stream into level 0 over as many frames as the budget needs, and when the last
+// one is in the base level drops to 0 and the mip chain is generated, so the texture
+// switches from placeholder to the full image between two frames.
+class TextureStreamer
+{
+public:
+    static const size_t DefaultFrameBudget = 8 << 20;
+
+    TextureStreamer(size_t frameBudget = DefaultFrameBudget);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // The streamer every texture loader shares, created on first use with a current context
+    static TextureStreamer& Shared();
+
+    unsigned int Load(const std::string &path, const TextureLoadOptions &options = TextureLoadOptions());
+    // faces in +X, -X, +Y, -Y, +Z, -Z order, never flipped, clamped to the edge
+    unsigned int LoadCubeMap(const std::vector<std::string> &faces,
+                             const TextureLoadOptions &options = TextureLoadOptions());
+    // Streams a finer mip level into a complete texture whose finer levels were dropped. It keeps
+    // sampling its current levels until level is in and becomes the base level, the levels in
+    // between are generated from it. Cube maps give their six faces. False if texture is streaming.
+    bool Reload(unsigned int texture, GLenum target, const std::vector<std::string> &paths, bool flipVertically,
+                int level, TextureReady ready);
+    // Runs ready when texture is complete. Returns false, and never runs it, if the texture
+    // is not being streamed: it is already complete or came from somewhere else.
+    bool WhenReady(unsigned int texture, TextureReady ready);
+    // Stops streaming into texture, which is about to be deleted. Its ready callbacks never run.
+    void Cancel(unsigned int texture);
+    // The texture still shows its placeholder
+    bool IsPending(unsigned int texture) const { return textures.count(texture) > 0; }
+
+    // Once per frame on the GL thread: takes the finished decodes and uploads up to FrameBudget bytes
+    void Update();
+
+    size_t FrameBudget() const { return ring.FrameBytes(); }
+    // textures still showing their placeholder
+    unsigned int PendingCount() const { return textures.size(); }
+    // decoded bytes waiting for the ring
+    size_t PendingBytes() const { return pendingBytes; }
+    size_t UploadedBytes() const { return uploadedBytes; }
+    size_t FrameUploadedBytes() const { return frameUploadedBytes; }
+    unsigned int CompletedCount() const { return completed; }
+
+private:
+    struct StreamedTexture
+    {
+        unsigned int texture = 0;
+        GLenum target = GL_TEXTURE_2D;
+        unsigned char placeholder[4];
+        // the level being streamed, only a Reload has one other than 0
+        int level = 0;
+        bool reload = false;
+        // faces not uploaded yet
+        unsigned int facesLeft = 0;
+        // level 0 allocated, the placeholder moved to the smallest level
+        bool allocated = false;
+        // a face could not be decoded or did not fit, the placeholder stays
+        bool failed = false;
+        int width = 0, height = 0;
+        bool hasAlpha = false;
+        std::vector<TextureReady> ready;
+    };
+    // One decoded image (a cube map face) on its way to the ring
+    struct Upload
+    {
+        std::shared_ptr<StreamedTexture> texture;
+        GLenum faceTarget;
+        DecodedImage image;
+        int nextRow;
+    };
+    // rows copied into the ring this frame, uploaded once the ring is committed
+    struct RowCopy
+    {
+        unsigned int texture;
+        GLenum target, faceTarget;
+        GLenum format;
+        int level, firstRow, rows, width;
+        size_t offset;
+    };
+
+    StreamBuffer ring;
+    std::unordered_map<unsigned int, std::shared_ptr<StreamedTexture>> textures;
+    std::deque<Upload> uploads;
+    std::vector<RowCopy> copies;
+    std::vector<std::shared_ptr<StreamedTexture>> finished;
+    size_t pendingBytes, uploadedBytes, frameUploadedBytes;
+    unsigned int completed;
+
+    unsigned int create(GLenum target, const TextureLoadOptions &options);
+    // Queues the decoded image of one face
+    void decoded(const std::shared_ptr<StreamedTexture> &texture, GLenum faceTarget, DecodedImage &image);
+    // Allocates level 0 of every face at the image size behind the placeholder
+    void allocate(StreamedTexture &texture, const DecodedImage &image);
+    void complete(StreamedTexture &texture);
+    // Drops a face that cannot be uploaded, the texture keeps its placeholder
+    void fail(StreamedTexture &texture);
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef VERTEX_PACKING_H
+#define VERTEX_PACKING_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// Compact Mesh vertex, 20 bytes instead of the 56 of Vertex:
+// position as unorm16 inside the mesh bounds, normal as octahedral snorm16,
+// tangent as octahedral 10:10 with the bitangent sign in the 2 bit w of a
+// GL_INT_2_10_10_10_REV, texture coordinates as unorm16 inside the mesh UV bounds.
+struct PackedMeshVertex
+{
+    uint16_t position[3];
+    uint16_t padding;
+    int16_t normal[2];
+    uint32_t tangent;
+    uint16_t texCoords[2];
+};
+
+// Compact sphere vertex, 8 bytes instead of 32. Spheres are unit spheres so the
+// position is the decoded normal scaled by the sphereRadius uniform.
+struct PackedSphereVertex
+{
+    int16_t normal[2];
+    uint16_t texCoords[2];
+};
+
+// Maps unorm16 values back to the original ranges: value = offset + unorm * scale
+struct QuantizationBounds
+{
+    glm::vec3 positionOffset;
+    glm::vec3 positionScale;
+    glm::vec2 texCoordOffset;
+    glm::vec2 texCoordScale;
+};
+
+// Octahedral encoding of a unit vector into [-1, 1]^2
+glm::vec2 octEncode(glm::vec3 n);
+
+int16_t packSnorm16(float value);
+uint16_t packUnorm16(float value);
+
+// Tangent and bitangent sign as GL_INT_2_10_10_10_REV
+uint32_t packTangent(glm::vec3 tangent, float bitangentSign);
+
+#endif
@@ -4,10 +4,26 @@
 
 #ifndef PROJECT_BASE_COMMON_H
 #define PROJECT_BASE_COMMON_H
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <iostream>
+
+#define GL_ERROR_CHECK(A) \
+do { \
+    A; \
+    GLenum error = glGetError(); \
+    if(error != GL_NO_ERROR) { \
+        std::cout << "Opengl error: " << error << std::endl; \
+        std::cout << __FILE__ << ":" << __LINE__ << " " << __func__ << std::endl; \
+    }\
+} while(0)
 
 std::string readFileContents(std::string path);
 
+// FNV-1a, seed chains hashes of several buffers
+size_t hashBytes(const void *data, size_t size, size_t seed = 14695981039346656037ull);
+
 #endif //PROJECT_BASE_COMMON_H
@@ -7,7 +7,13 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <learnopengl/shader.h>
+#include <GeometryArena.hpp>
+#include <Culling.hpp>
+#include <Material.hpp>
+#include <VertexPacking.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <string>
 #include <vector>
 using namespace std;
@@ -27,6 +33,19 @@ struct Vertex {
 
 
 
+// Arena shared by every Mesh, one VAO for the PackedMeshVertex layout.
+// Vertex is only the import format, meshes are packed when they are uploaded.
+inline GeometryArena& MeshArena()
+{
+    static GeometryArena arena(sizeof(PackedMeshVertex), {
+        {0, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(PackedMeshVertex, position)},
+        {1, 2, GL_SHORT, GL_TRUE, offsetof(PackedMeshVertex, normal)},
+        {2, 2, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(PackedMeshVertex, texCoords)},
+        {3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(PackedMeshVertex, tangent)},
+    }, 1 << 16, 1 << 18);
+    return arena;
+}
+
 struct Texture {
     unsigned int id;
     string type;
@@ -40,8 +59,14 @@ public:
     vector<unsigned int> indices;
     vector<Texture>      textures;
 
-    unsigned int VAO;
-    std::string glslIdentifierPrefix;
+    // where the mesh lives in MeshArena, more than one range if it was split to fit 16 bit indices
+    vector<GeometryRange> ranges;
+    // decodes the unorm16 position and texture coordinates
+    QuantizationBounds bounds;
+    // model space bounds used for frustum culling
+    BoundingSphere boundingSphere;
+    // textures by slot and shading parameters, built from textures
+    Material material;
     // constructor
     Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
     {
@@ -49,91 +74,64 @@ public:
         this->indices = indices;
         this->textures = textures;
 
+        for(const Texture &texture : textures)
+            material.SetTexture(textureSlotOf(texture.type), texture.id);
+
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
     }
 
-    // render the mesh
-    void Draw(Shader &shader)
+private:
+    // packs the vertices and uploads them into the shared arena
+    void setupMesh()
     {
-        // bind appropriate textures
-        unsigned int diffuseNr  = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr   = 1;
-        unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
+        glm::vec3 minPosition = vertices[0].Position, maxPosition = vertices[0].Position;
+        glm::vec2 minTexCoords = vertices[0].TexCoords, maxTexCoords = vertices[0].TexCoords;
+        for(const Vertex &v : vertices)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to stream
-            else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to stream
-            else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (glslIdentifierPrefix + name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            minPosition = glm::min(minPosition, v.Position);
+            maxPosition = glm::max(maxPosition, v.Position);
+            minTexCoords = glm::min(minTexCoords, v.TexCoords);
+            maxTexCoords = glm::max(maxTexCoords, v.TexCoords);
         }
 
+        // a flat axis would divide by zero, any scale decodes it back to the offset
+        bounds.positionOffset = minPosition;
+        bounds.positionScale = glm::max(maxPosition - minPosition, glm::vec3(1e-6f));
+        bounds.texCoordOffset = minTexCoords;
+        bounds.texCoordScale = glm::max(maxTexCoords - minTexCoords, glm::vec2(1e-6f));
 
+        boundingSphere.center = (minPosition + maxPosition) * 0.5f;
+        boundingSphere.radius = 0;
+        for(const Vertex &v : vertices)
+            boundingSphere.radius = std::max(boundingSphere.radius, glm::length(v.Position - boundingSphere.center));
 
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
-    }
-
-private:
-    // render data
-    unsigned int VBO, EBO;
+        vector<PackedMeshVertex> packed(vertices.size());
+        for(unsigned int i = 0; i < vertices.size(); i++)
+        {
+            const Vertex &v = vertices[i];
+            PackedMeshVertex &p = packed[i];
+
+            const glm::vec3 position = (v.Position - bounds.positionOffset) / bounds.positionScale;
+            p.position[0] = packUnorm16(position.x);
+            p.position[1] = packUnorm16(position.y);
+            p.position[2] = packUnorm16(position.z);
+            p.padding = 0;
+
+            const glm::vec2 normal = octEncode(v.Normal);
+            p.normal[0] = packSnorm16(normal.x);
+            p.normal[1] = packSnorm16(normal.y);
+
+            // the bitangent is rebuilt as sign * cross(normal, tangent)
+            const float bitangentSign = glm::dot(glm::cross(v.Normal, v.Tangent), v.Bitangent) < 0 ? -1.0f : 1.0f;
+            p.tangent = packTangent(v.Tangent, bitangentSign);
+
+            const glm::vec2 texCoords = (v.TexCoords - bounds.texCoordOffset) / bounds.texCoordScale;
+            p.texCoords[0] = packUnorm16(texCoords.x);
+            p.texCoords[1] = packUnorm16(texCoords.y);
+        }
 
-    // initializes all the buffer objects/arrays
-    void setupMesh()
-    {
-        // create buffers/arrays
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-        // load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-
-        glBindVertexArray(0);
+        ranges = MeshArena().AllocateSplit(packed.data(), packed.size(), indices.data(), indices.size());
     }
 };
 #endif
\ No newline at end of file
@@ -4,34 +4,103 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <string>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <common.h>
+#include <RenderState.hpp>
+#include <FrameUniforms.hpp>
+#include <ProgramCache.hpp>
+#include <GLExtensions.hpp>
 
+// A uniform location resolved once, setting through it skips the name lookup.
+// An invalid handle (location -1) is ignored by glUniform* like an unknown name.
+struct UniformHandle
+{
+    GLint location = -1;
+
+    bool IsValid() const { return location >= 0; }
+};
+
+// What reflection found about an active uniform outside of a block
+struct UniformInfo
+{
+    GLint location;
+    GLenum type;
+    GLint size;
+};
+
+// Source text of every stage with the defines already injected. Reading it does not
+// touch GL, so it can happen on any thread.
+struct ShaderSources
+{
+    std::string vertexCode;
+    std::string fragmentCode;
+    std::string geometryCode;
+    bool hasGeometry = false;
+};
 
 class Shader
 {
 public:
     unsigned int ID;
-    std::string vPath, fPath;
-    // constructor generates the shader on the fly
+    std::string vPath, fPath, gPath;
+    // active default block uniforms by name, array elements are listed as name[i] and the array as name
+    std::unordered_map<std::string, UniformInfo> uniforms;
+    // active uniform blocks by name
+    std::vector<std::string> uniformBlocks;
+    // names #defined in every stage of this program
+    std::vector<std::string> defines;
+    // constructor generates the shader on the fly, defines are injected after the #version line
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr,
+           const std::vector<std::string> &defines = {})
+        : ID(0), vPath(vertexPath), fPath(fragmentPath), gPath(geometryPath ? geometryPath : ""), defines(defines)
     {
-        std::string vertexPathString(vertexPath);
-        std::string fragmentPathString(fragmentPath);
-
-        vPath = vertexPathString;
-        fPath = fragmentPathString;
-
-        vertexPath = vertexPathString.c_str();
-        fragmentPath= fragmentPathString.c_str();
+        Instances().push_back(this);
         // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
+        ShaderSources sources = ReadSources(vPath, fPath, gPath, defines);
+        // 2. reuse the program binary of an earlier run, or compile and link from source
+        build = startBuild(sources);
+        ID = build.program;
+        FinishBuild();
+    }
+    // deferred build, the sources are being read elsewhere (see ShaderBuildQueue).
+    // Nothing touches GL until StartBuild or the first use.
+    // ------------------------------------------------------------------------
+    Shader(const std::string &vertexPath, const std::string &fragmentPath, std::future<ShaderSources> sources,
+           const std::vector<std::string> &defines = {})
+        : ID(0), vPath(vertexPath), fPath(fragmentPath), defines(defines), pendingSources(std::move(sources))
+    {
+        Instances().push_back(this);
+    }
+    ~Shader()
+    {
+        std::vector<Shader*> &instances = Instances();
+        instances.erase(std::remove(instances.begin(), instances.end(), this), instances.end());
+    }
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+    // every live shader, for hot reloading
+    static std::vector<Shader*>& Instances()
+    {
+        static std::vector<Shader*> instances;
+        return instances;
+    }
+    // reads every stage from disk and injects the defines, safe to call from any thread
+    // ------------------------------------------------------------------------
+    static ShaderSources ReadSources(const std::string &vertexPath, const std::string &fragmentPath,
+                                     const std::string &geometryPath, const std::vector<std::string> &defines)
+    {
+        ShaderSources sources;
+        sources.hasGeometry = !geometryPath.empty();
         std::ifstream vShaderFile;
         std::ifstream fShaderFile;
         std::ifstream gShaderFile;
@@ -52,132 +121,451 @@ public:
             vShaderFile.close();
             fShaderFile.close();
             // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
+            sources.vertexCode = vShaderStream.str();
+            sources.fragmentCode = fShaderStream.str();
             // if geometry shader path is present, also load a geometry shader
-            if(geometryPath != nullptr)
+            if(sources.hasGeometry)
             {
-                std::string geometryPathString(geometryPath);
-                geometryPath = geometryPathString.c_str();
                 gShaderFile.open(geometryPath);
                 std::stringstream gShaderStream;
                 gShaderStream << gShaderFile.rdbuf();
                 gShaderFile.close();
-                geometryCode = gShaderStream.str();
+                sources.geometryCode = gShaderStream.str();
             }
         }
         catch (std::ifstream::failure& e)
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+            std::cout << vertexPath << std::endl << fragmentPath << std::endl;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
-        if(geometryPath != nullptr)
+        sources.vertexCode = injectDefines(sources.vertexCode, defines);
+        sources.fragmentCode = injectDefines(sources.fragmentCode, defines);
+        if(sources.hasGeometry)
+            sources.geometryCode = injectDefines(sources.geometryCode, defines);
+        return sources;
+    }
+    // deferred builds: issues the compile and link without waiting for them, blocks only
+    // until the sources are read. The driver may compile in the background meanwhile.
+    // ------------------------------------------------------------------------
+    void StartBuild()
+    {
+        if(pendingSources.valid())
         {
-            const char * gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
+            build = startBuild(pendingSources.get());
+            ID = build.program;
         }
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessery
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if(geometryPath != nullptr)
-            glDeleteShader(geometry);
+    }
+    // never blocks, always true when the driver can not report progress
+    bool IsBuildComplete() const
+    {
+        return ready || (build.program != 0 && isComplete(build));
+    }
+    bool IsReady() const { return ready; }
+    // waits for the program and reads back its state, done automatically on first use
+    void FinishBuild()
+    {
+        if(ready)
+            return;
+        StartBuild();
+        finishBuild(build, buildLog);
+        adopt(build.program);
+    }
+    // rebuilds the program from the files on disk in the background. The current
+    // program stays in use until PollReload swaps the new one in.
+    // ------------------------------------------------------------------------
+    void Reload()
+    {
+        if(!ready)
+            return;
+        // a newer edit replaces a reload still in flight
+        if(reloading)
+            discard(reload);
+        reload = startBuild(ReadSources(vPath, fPath, gPath, defines));
+        reloading = true;
+    }
+    // never blocks while the driver compiles, returns true when the new program was swapped in.
+    // A reload that fails to compile is dropped and the old program keeps running.
+    bool PollReload()
+    {
+        if(!reloading || !isComplete(reload))
+            return false;
+        reloading = false;
 
+        std::string log;
+        if(!finishBuild(reload, log))
+        {
+            discard(reload);
+            buildLog = log;
+            return false;
+        }
+        RenderState::ForgetProgram(ID);
+        glDeleteProgram(ID);
+        // the old sources will not be built again, their binary would stay in the cache forever
+        if(reload.cacheKey != build.cacheKey)
+            ProgramCache::Remove(build.cacheKey);
+        build.cacheKey = reload.cacheKey;
+        buildLog.clear();
+        adopt(reload.program);
+        return true;
+    }
+    bool IsReloading() const { return reloading; }
+    // compile and link errors of the last build, empty when it succeeded
+    const std::string& BuildLog() const { return buildLog; }
+    // changes whenever ID, and with it the uniform locations, changes
+    unsigned int Generation() const { return generation; }
+    // runs after every successful link, right away when the program is already built.
+    // Uniforms that never change and cached handles belong here, a reload resets them.
+    void SetLinkCallback(std::function<void(Shader&)> callback)
+    {
+        linkCallback = callback;
+        if(ready && linkCallback)
+            linkCallback(*this);
     }
     // activate the shader
     // ------------------------------------------------------------------------
     void use()
     {
-        glUseProgram(ID);
+        FinishBuild();
+        RenderState::UseProgram(ID);
+    }
+    // resolves a uniform for the setters below, hot paths should keep the handle
+    // instead of passing the name every time. Unknown names are reported once.
+    // ------------------------------------------------------------------------
+    UniformHandle GetUniform(const std::string &name) const
+    {
+        UniformHandle handle = FindUniform(name);
+        if(!handle.IsValid() && reportedMissing.insert(name).second)
+            std::cout << "WARNING::SHADER::UNIFORM_NOT_ACTIVE: " << name << " (misspelled or optimized out)\n"
+                      << vPath << std::endl << fPath << std::endl;
+        return handle;
+    }
+    // declares the uniforms a caller sets by name, they are checked after every link so a
+    // misspelled one is reported as soon as the program is built rather than when first set
+    void ExpectUniforms(const std::vector<std::string> &names)
+    {
+        expectedUniforms.insert(expectedUniforms.end(), names.begin(), names.end());
+        if(ready)
+            checkExpectedUniforms();
+    }
+    // same as GetUniform but silent, for uniforms a shader may leave out
+    UniformHandle FindUniform(const std::string &name) const
+    {
+        // a deferred program only has its uniforms once it is built
+        if(!ready)
+            const_cast<Shader*>(this)->FinishBuild();
+        UniformHandle handle;
+        auto it = uniforms.find(name);
+        if(it != uniforms.end())
+            handle.location = it->second.location;
+        return handle;
+    }
+    bool HasUniformBlock(const std::string &name) const
+    {
+        for(const std::string &block : uniformBlocks)
+            if(block == name)
+                return true;
+        return false;
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
+    void setBool(UniformHandle handle, bool value) const
+    {
+        glUniform1i(handle.location, (int)value);
+    }
     void setBool(const std::string &name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        setBool(GetUniform(name), value);
     }
     // ------------------------------------------------------------------------
+    void setInt(UniformHandle handle, int value) const
+    {
+        glUniform1i(handle.location, value);
+    }
     void setInt(const std::string &name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        setInt(GetUniform(name), value);
     }
     // ------------------------------------------------------------------------
+    void setFloat(UniformHandle handle, float value) const
+    {
+        glUniform1f(handle.location, value);
+    }
     void setFloat(const std::string &name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        setFloat(GetUniform(name), value);
     }
     // ------------------------------------------------------------------------
+    void setVec2(UniformHandle handle, const glm::vec2 &value) const
+    {
+        glUniform2fv(handle.location, 1, &value[0]);
+    }
     void setVec2(const std::string &name, const glm::vec2 &value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        setVec2(GetUniform(name), value);
     }
     void setVec2(const std::string &name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        glUniform2f(GetUniform(name).location, x, y);
     }
     // ------------------------------------------------------------------------
+    void setVec3(UniformHandle handle, const glm::vec3 &value) const
+    {
+        glUniform3fv(handle.location, 1, &value[0]);
+    }
     void setVec3(const std::string &name, const glm::vec3 &value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        setVec3(GetUniform(name), value);
     }
     void setVec3(const std::string &name, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        glUniform3f(GetUniform(name).location, x, y, z);
     }
     // ------------------------------------------------------------------------
+    void setVec4(UniformHandle handle, const glm::vec4 &value) const
+    {
+        glUniform4fv(handle.location, 1, &value[0]);
+    }
     void setVec4(const std::string &name, const glm::vec4 &value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        setVec4(GetUniform(name), value);
     }
     void setVec4(const std::string &name, float x, float y, float z, float w)
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        glUniform4f(GetUniform(name).location, x, y, z, w);
     }
     // ------------------------------------------------------------------------
+    void setMat2(UniformHandle handle, const glm::mat2 &mat) const
+    {
+        glUniformMatrix2fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+    }
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat2(GetUniform(name), mat);
     }
     // ------------------------------------------------------------------------
+    void setMat3(UniformHandle handle, const glm::mat3 &mat) const
+    {
+        glUniformMatrix3fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+    }
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat3(GetUniform(name), mat);
     }
     // ------------------------------------------------------------------------
+    void setMat4(UniformHandle handle, const glm::mat4 &mat) const
+    {
+        glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+    }
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat4(GetUniform(name), mat);
     }
 
 private:
+    // a program between startBuild and finishBuild
+    struct PendingProgram
+    {
+        unsigned int program = 0;
+        unsigned int vertex = 0, fragment = 0, geometry = 0;
+        std::string cacheKey;
+        bool fromCache = false;
+    };
+
+    std::future<ShaderSources> pendingSources;
+    PendingProgram build;
+    PendingProgram reload;
+    bool reloading = false;
+    bool ready = false;
+    unsigned int generation = 0;
+    std::string buildLog;
+    std::function<void(Shader&)> linkCallback;
+
+    // the #version directive has to stay the first line, defines go right after it
+    // ------------------------------------------------------------------------
+    static std::string injectDefines(const std::string &code, const std::vector<std::string> &defines)
+    {
+        if(defines.empty())
+            return code;
+
+        std::string block;
+        for(const std::string &define : defines)
+            block += "#define " + define + "\n";
+
+        std::string::size_type version = code.find("#version");
+        if(version == std::string::npos)
+            return block + code;
+        std::string::size_type lineEnd = code.find('\n', version);
+        if(lineEnd == std::string::npos)
+            return code + "\n" + block;
+        return code.substr(0, lineEnd + 1) + block + code.substr(lineEnd + 1);
+    }
+
+    // loads the cached binary or issues the compiles and the link. Errors are only
+    // checked in finishBuild, querying them here would wait for the compiler.
+    // ------------------------------------------------------------------------
+    static PendingProgram startBuild(const ShaderSources &sources)
+    {
+        PendingProgram pending;
+        pending.program = glCreateProgram();
+        pending.cacheKey = ProgramCache::Key({sources.vertexCode, sources.fragmentCode, sources.geometryCode});
+        pending.fromCache = ProgramCache::Load(pending.program, pending.cacheKey);
+        if(pending.fromCache)
+            return pending;
+
+        const char* vShaderCode = sources.vertexCode.c_str();
+        const char * fShaderCode = sources.fragmentCode.c_str();
+        // vertex shader
+        pending.vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(pending.vertex, 1, &vShaderCode, NULL);
+        glCompileShader(pending.vertex);
+        // fragment Shader
+        pending.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(pending.fragment, 1, &fShaderCode, NULL);
+        glCompileShader(pending.fragment);
+        // if geometry shader is given, compile geometry shader
+        if(sources.hasGeometry)
+        {
+            const char * gShaderCode = sources.geometryCode.c_str();
+            pending.geometry = glCreateShader(GL_GEOMETRY_SHADER);
+            glShaderSource(pending.geometry, 1, &gShaderCode, NULL);
+            glCompileShader(pending.geometry);
+        }
+        // shader Program
+        glAttachShader(pending.program, pending.vertex);
+        glAttachShader(pending.program, pending.fragment);
+        if(pending.geometry != 0)
+            glAttachShader(pending.program, pending.geometry);
+        ProgramCache::MarkRetrievable(pending.program);
+        glLinkProgram(pending.program);
+        return pending;
+    }
+
+    static bool isComplete(const PendingProgram &pending)
+    {
+        if(pending.fromCache || !GLExtensions::HasParallelShaderCompile)
+            return true;
+        GLint complete = GL_FALSE;
+        glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &complete);
+        return complete == GL_TRUE;
+    }
+
+    // reports compile and link errors into log and stores the binary, returns whether the program linked
+    // ------------------------------------------------------------------------
+    bool finishBuild(PendingProgram &pending, std::string &log)
+    {
+        if(pending.fromCache)
+            return true;
+
+        checkCompileErrors(pending.vertex, "VERTEX", log);
+        checkCompileErrors(pending.fragment, "FRAGMENT", log);
+        if(pending.geometry != 0)
+            checkCompileErrors(pending.geometry, "GEOMETRY", log);
+        checkCompileErrors(pending.program, "PROGRAM", log);
+        // delete the shaders as they're linked into our program now and no longer necessery
+        glDeleteShader(pending.vertex);
+        glDeleteShader(pending.fragment);
+        if(pending.geometry != 0)
+            glDeleteShader(pending.geometry);
+        pending.vertex = pending.fragment = pending.geometry = 0;
+
+        GLint success;
+        glGetProgramiv(pending.program, GL_LINK_STATUS, &success);
+        if(success != GL_TRUE)
+            return false;
+        ProgramCache::Store(pending.program, pending.cacheKey);
+        return true;
+    }
+
+    // drops a build that will not be used
+    static void discard(PendingProgram &pending)
+    {
+        glDeleteShader(pending.vertex);
+        glDeleteShader(pending.fragment);
+        glDeleteShader(pending.geometry);
+        glDeleteProgram(pending.program);
+        pending = PendingProgram();
+    }
+
+    // makes program the current one and reads back its state
+    void adopt(unsigned int program)
+    {
+        ID = program;
+        FrameUniforms::BindBlocks(ID);
+        reflect();
+        reportedMissing.clear();
+        ready = true;
+        checkExpectedUniforms();
+        ++generation;
+        if(linkCallback)
+            linkCallback(*this);
+    }
+
+    // names already reported as not active, so each is reported once
+    mutable std::unordered_set<std::string> reportedMissing;
+    std::vector<std::string> expectedUniforms;
+
+    void checkExpectedUniforms() const
+    {
+        for(const std::string &name : expectedUniforms)
+            GetUniform(name);
+    }
+
+    // fills uniforms and uniformBlocks from the linked program
+    // ------------------------------------------------------------------------
+    void reflect()
+    {
+        uniforms.clear();
+        uniformBlocks.clear();
+
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> nameBuffer(std::max(maxLength, 1));
+        for(GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+            std::string name(nameBuffer.data(), length);
+
+            // members of uniform blocks have no location
+            GLint location = glGetUniformLocation(ID, name.c_str());
+            if(location < 0)
+                continue;
+
+            // arrays of basic types are reported as name[0], register the bare name and every element.
+            // Members of arrays of structs (foo[1].bar) are reported one by one and kept as they are.
+            const std::string arraySuffix = "[0]";
+            if(name.size() > arraySuffix.size()
+               && name.compare(name.size() - arraySuffix.size(), arraySuffix.size(), arraySuffix) == 0)
+            {
+                std::string base = name.substr(0, name.size() - arraySuffix.size());
+                uniforms[base] = UniformInfo{location, type, size};
+                for(GLint element = 0; element < size; element++)
+                {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    uniforms[elementName] = UniformInfo{glGetUniformLocation(ID, elementName.c_str()), type, 1};
+                }
+            }
+            else
+                uniforms[name] = UniformInfo{location, type, size};
+        }
+
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+        nameBuffer.resize(std::max(maxLength, 1));
+        for(GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            glGetActiveUniformBlockName(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, nameBuffer.data());
+            uniformBlocks.emplace_back(nameBuffer.data(), length);
+        }
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
-    void checkCompileErrors(GLuint shader, std::string type)
+    void checkCompileErrors(GLuint shader, std::string type, std::string &log)
     {
         GLint success;
         GLchar infoLog[1024];
@@ -187,6 +575,7 @@ private:
             if(!success)
             {
                 glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+                log += type + ": " + infoLog;
                 std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
                 std::cout << vPath << std::endl << fPath << std::endl;
             }
@@ -197,6 +586,7 @@ private:
             if(!success)
             {
                 glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+                log += type + ": " + infoLog;
                 std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
                 std::cout << vPath << std::endl << fPath << std::endl;
             }
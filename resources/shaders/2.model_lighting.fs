@@ -1,16 +1,22 @@
 #version 330 core
 out vec4 FragColor;
 
+// vec3s are padded to vec4s, attenuation is (constant, linear, quadratic, unused)
 struct PointLight {
-    vec3 position;
+    vec4 position;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation;
+};
 
-    vec3 specular;
-    vec3 diffuse;
-    vec3 ambient;
+// must match MaxPointLights in FrameUniforms.hpp
+#define MAX_POINT_LIGHTS 4
 
-    float constant;
-    float linear;
-    float quadratic;
+// per-frame lights, shared by all programs (LightData in FrameUniforms.hpp)
+layout (std140) uniform LightData {
+    int pointLightCount;
+    PointLight pointLights[MAX_POINT_LIGHTS];
 };
 
 struct Material {
@@ -23,17 +29,26 @@ in vec2 TexCoords;
 in vec3 Normal;
 in vec3 FragPos;
 
-uniform int HasTexture;
-uniform PointLight pointLight;
 uniform Material material;
 
-uniform sampler2D textureSampler;
+#ifdef HAS_TEXTURE
+// every planet texture, one layer each (PlanetRenderer)
+uniform sampler2DArray planetTextures;
+flat in float Layer;
+#endif
+
+// per-frame camera data, shared by all programs (FrameData in FrameUniforms.hpp)
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 skyboxView;
+    vec4 viewPosition;
+};
 
-uniform vec3 viewPosition;
 // calculates the color when using a point light.
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
-    vec3 lightDir = normalize(light.position - fragPos);
+    vec3 lightDir = normalize(light.position.xyz - fragPos);
     vec3 halfwayVec = normalize(lightDir + viewDir);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
@@ -41,16 +56,16 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     vec3 reflectDir = reflect(lightDir, normal);
     float spec = pow(max(dot(normal, halfwayVec), 0.0), 8);
     // attenuation
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    float distance = length(light.position.xyz - fragPos);
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));
     // combine results
     //#vec3 ambient = light.ambient * vec3(texture(material.texture_diffuse1, TexCoords));
     //#vec3 diffuse = light.diffuse * diff * vec3(texture(material.texture_diffuse1, TexCoords));
     //#vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, TexCoords).xxx);
 
-    vec3 ambient = light.ambient;
-    vec3 diffuse = light.diffuse * diff;
-    vec3 specular = light.specular * spec;
+    vec3 ambient = light.ambient.rgb;
+    vec3 diffuse = light.diffuse.rgb * diff;
+    vec3 specular = light.specular.rgb * spec;
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -60,15 +75,17 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 void main()
 {
     vec3 normal = normalize(Normal);
-    vec3 viewDir = normalize(viewPosition - FragPos);
-    vec3 result = CalcPointLight(pointLight, normal, FragPos, viewDir);
-    
-    if(HasTexture == 1) {
-        FragColor = vec4(result, 1.0) * texture(textureSampler, TexCoords);
-    }
-    else {
-        FragColor = vec4(result, 1.0);
+    vec3 viewDir = normalize(viewPosition.xyz - FragPos);
+    vec3 result = vec3(0.0);
+    for(int i = 0; i < pointLightCount; ++i) {
+        result += CalcPointLight(pointLights[i], normal, FragPos, viewDir);
     }
+    
+#ifdef HAS_TEXTURE
+    FragColor = vec4(result, 1.0) * texture(planetTextures, vec3(TexCoords, Layer));
+#else
+    FragColor = vec4(result, 1.0);
+#endif
 
 
 }
@@ -1,21 +1,44 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aTexCoords;
+// PackedSphereVertex: octahedral normal and unorm16 uv, position is the normal on a sphere of sphereRadius
+layout (location = 0) in vec2 aNormalOct;
+layout (location = 1) in vec2 aTexCoords;
 
 out vec2 TexCoords;
 out vec3 Normal;
 out vec3 FragPos;
 
-uniform mat3 normalMatrix;
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// per-frame camera data, shared by all programs (FrameData in FrameUniforms.hpp)
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 skyboxView;
+    vec4 viewPosition;
+};
 
-uniform float scale;
+// per-object transform, written to the frame's stream buffer (ObjectData in FrameUniforms.hpp)
+layout (std140) uniform ObjectData {
+    mat4 model;
+    mat3 normalMatrix;
+    float scale;
+};
+
+uniform float sphereRadius;
+
+// octahedral decoding of a unit vector stored as normalized snorm16
+vec3 octDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) {
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
 
 void main()
 {
+    vec3 aNormal = octDecode(aNormalOct);
+    vec3 aPos = sphereRadius * aNormal;
+
     FragPos = scale*vec3(model * vec4(aPos, 1.0));
     Normal = normalMatrix * aNormal;
     TexCoords = aTexCoords;
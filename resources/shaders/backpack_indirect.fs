@@ -0,0 +1,75 @@
+#version 330 core
+out vec4 FragColor;
+
+// vec3s are padded to vec4s, attenuation is (constant, linear, quadratic, unused)
+struct PointLight {
+    vec4 position;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation;
+};
+
+// must match MaxPointLights in FrameUniforms.hpp
+#define MAX_POINT_LIGHTS 4
+
+// per-frame lights, shared by all programs (LightData in FrameUniforms.hpp)
+layout (std140) uniform LightData {
+    int pointLightCount;
+    PointLight pointLights[MAX_POINT_LIGHTS];
+};
+
+// per-frame camera data, shared by all programs (FrameData in FrameUniforms.hpp)
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 skyboxView;
+    vec4 viewPosition;
+};
+
+in vec2 TexCoords;
+in vec3 Normal;
+in vec3 FragPos;
+flat in int DiffuseLayer;
+flat in int SpecularLayer;
+flat in float Shininess;
+
+// one layer per distinct texture of the model
+uniform sampler2DArray diffuseTextures;
+uniform sampler2DArray specularTextures;
+
+// calculates the color when using a point light.
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec3 lightDir = normalize(light.position.xyz - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), Shininess);
+    // attenuation
+    float distance = length(light.position.xyz - fragPos);
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));
+    // combine results
+    vec3 ambient = light.ambient.rgb * albedo;
+    vec3 diffuse = light.diffuse.rgb * diff * albedo;
+    vec3 specular = light.specular.rgb * spec * specularMask;
+    ambient *= attenuation;
+    diffuse *= attenuation;
+    specular *= attenuation;
+    return (ambient + diffuse + specular);
+}
+
+void main()
+{
+    vec3 albedo = texture(diffuseTextures, vec3(TexCoords, DiffuseLayer)).rgb;
+    float specularMask = texture(specularTextures, vec3(TexCoords, SpecularLayer)).r;
+
+    vec3 normal = normalize(Normal);
+    vec3 viewDir = normalize(viewPosition.xyz - FragPos);
+    vec3 result = vec3(0.0);
+    for(int i = 0; i < pointLightCount; ++i) {
+        result += CalcPointLight(pointLights[i], normal, FragPos, viewDir, albedo, specularMask);
+    }
+    FragColor = vec4(result, 1.0);
+}
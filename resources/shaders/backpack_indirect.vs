@@ -0,0 +1,83 @@
+#version 330 core
+// Built with INDIRECT_DRAW for glMultiDrawElementsIndirect, without it for the GL 3.3 loop,
+// see IndirectModel.hpp. The #define is injected right after #version.
+#ifdef INDIRECT_DRAW
+#extension GL_ARB_shader_storage_buffer_object : require
+#extension GL_ARB_shader_draw_parameters : require
+#extension GL_ARB_shading_language_420pack : require
+#endif
+
+// PackedMeshVertex: unorm16 position and uv inside the mesh bounds, octahedral normal
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aNormalOct;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+out vec3 Normal;
+out vec3 FragPos;
+flat out int DiffuseLayer;
+flat out int SpecularLayer;
+flat out float Shininess;
+
+// per-frame camera data, shared by all programs (FrameData in FrameUniforms.hpp)
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 skyboxView;
+    vec4 viewPosition;
+};
+
+// quantization bounds and material of one mesh (IndirectDrawData in IndirectModel.hpp)
+struct DrawData {
+    vec4 positionOffset;
+    vec4 positionScale;
+    vec4 texCoordTransform;
+    int diffuseLayer;
+    int specularLayer;
+    float shininess;
+    float padding;
+};
+
+#ifdef INDIRECT_DRAW
+// binding points from StorageBinding in IndirectModel.hpp
+layout (std430, binding = 0) readonly buffer DrawDataBlock {
+    DrawData draws[];
+};
+layout (std430, binding = 1) readonly buffer InstanceDataBlock {
+    mat4 instanceModels[];
+};
+// one entry per command with where its visible instances start in the same array, then the instances
+layout (std430, binding = 2) readonly buffer InstanceIndexBlock {
+    uint instanceIndices[];
+};
+#define DRAW draws[gl_DrawIDARB]
+#define MODEL instanceModels[instanceIndices[instanceIndices[gl_DrawIDARB] + uint(gl_InstanceID)]]
+#else
+uniform DrawData draw;
+uniform mat4 model;
+#define DRAW draw
+#define MODEL model
+#endif
+
+// octahedral decoding of a unit vector stored as normalized snorm16
+vec3 octDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) {
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
+
+void main()
+{
+    vec3 position = DRAW.positionOffset.xyz + aPos * DRAW.positionScale.xyz;
+
+    FragPos = vec3(MODEL * vec4(position, 1.0));
+    Normal = mat3(MODEL) * octDecode(aNormalOct);
+    TexCoords = DRAW.texCoordTransform.xy + aTexCoords * DRAW.texCoordTransform.zw;
+    DiffuseLayer = DRAW.diffuseLayer;
+    SpecularLayer = DRAW.specularLayer;
+    Shininess = DRAW.shininess;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,47 @@
+#version 330 core
+// PackedSphereVertex: octahedral normal and unorm16 uv, position is the normal on a sphere of sphereRadius
+layout (location = 0) in vec2 aNormalOct;
+layout (location = 1) in vec2 aTexCoords;
+
+// per-instance attributes
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in mat3 aNormalMatrix;
+layout (location = 10) in vec2 aScaleLayer;
+
+out vec2 TexCoords;
+out vec3 Normal;
+out vec3 FragPos;
+// texture array layer, negative for untextured bodies
+flat out float Layer;
+
+// per-frame camera data, shared by all programs (FrameData in FrameUniforms.hpp)
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 skyboxView;
+    vec4 viewPosition;
+};
+
+uniform float sphereRadius;
+
+// octahedral decoding of a unit vector stored as normalized snorm16
+vec3 octDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) {
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
+
+void main()
+{
+    vec3 aNormal = octDecode(aNormalOct);
+    vec3 aPos = sphereRadius * aNormal;
+
+    FragPos = aScaleLayer.x*vec3(aModel * vec4(aPos, 1.0));
+    Normal = aNormalMatrix * aNormal;
+    TexCoords = aTexCoords;
+    Layer = aScaleLayer.y;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
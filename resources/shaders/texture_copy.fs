@@ -0,0 +1,13 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+
+void main()
+{
+    // level 0 with bilinear filtering, the same resample a linear blit does
+    FragColor = textureLod(source, TexCoords, 0.0);
+}
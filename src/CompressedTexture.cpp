@@ -0,0 +1,71 @@
+#include <CompressedTexture.hpp>
+#include <GLExtensions.hpp>
+#include <KtxFile.hpp>
+#include <RenderState.hpp>
+#include <common.h>
+
+#include <iostream>
+
+namespace {
+    bool formatSupported(GLenum internalFormat)
+    {
+        switch(internalFormat) {
+            case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                return GLExtensions::HasTextureCompressionS3TC;
+            default:
+                return false;
+        }
+    }
+}
+
+unsigned int loadCompressedTexture(const std::string &path, GLenum target, bool flipVertically, bool *hasAlpha)
+{
+    KtxFile ktx;
+    if(!ktx.Read(path)) {
+        return 0;
+    }
+    // a file baked the other way round is not an error, the same image may be loaded both ways
+    if(ktx.orientation == KtxFile::OrientationUnknown) {
+        std::cout << "ERROR::COMPRESSED_TEXTURE: " << path << " does not record its orientation, bake it again"
+                  << std::endl;
+        return 0;
+    }
+    if(ktx.orientation != (flipVertically ? KtxFile::OrientationUp : KtxFile::OrientationDown)) {
+        return 0;
+    }
+    const unsigned int faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    if(ktx.faces != faces || ktx.Levels() == 0) {
+        std::cout << "ERROR::COMPRESSED_TEXTURE: " << path << " has " << ktx.faces << " faces, expected " << faces
+                  << std::endl;
+        return 0;
+    }
+    if(!formatSupported(ktx.internalFormat)) {
+        std::cout << "ERROR::COMPRESSED_TEXTURE: format 0x" << std::hex << ktx.internalFormat << std::dec
+                  << " of " << path << " is not supported, using the source image" << std::endl;
+        return 0;
+    }
+
+    unsigned int texture;
+    GL_ERROR_CHECK(glGenTextures(1, &texture));
+    RenderState::BindTexture(0, target, texture);
+    for(unsigned int level = 0; level < ktx.Levels(); ++level) {
+        for(unsigned int face = 0; face < faces; ++face) {
+            const GLenum faceTarget = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+            const std::vector<unsigned char> &data = ktx.data[level][face];
+            GL_ERROR_CHECK(glCompressedTexImage2D(faceTarget, level, ktx.internalFormat, ktx.LevelWidth(level),
+                                                  ktx.LevelHeight(level), 0, data.size(), &data[0]));
+        }
+    }
+
+    // the baker may stop the chain early, the texture is only complete up to the last level present
+    GL_ERROR_CHECK(glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, ktx.Levels() - 1));
+    GL_ERROR_CHECK(glTexParameteri(target, GL_TEXTURE_MIN_FILTER,
+                                   ktx.Levels() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+    GL_ERROR_CHECK(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+
+    if(hasAlpha) {
+        *hasAlpha = ktx.baseInternalFormat == GL_RGBA;
+    }
+    return texture;
+}
@@ -0,0 +1,118 @@
+#include <Culling.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CULLING_SSE 1
+#endif
+
+BoundingSphere transformSphere(const BoundingSphere &sphere, const glm::mat4 &transform)
+{
+    BoundingSphere result;
+    result.center = glm::vec3(transform * glm::vec4(sphere.center, 1.0f));
+
+    const float scale = std::max(glm::length(glm::vec3(transform[0])),
+                                 std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+    result.radius = sphere.radius * scale;
+    return result;
+}
+
+Frustum::Frustum(const glm::mat4 &m)
+{
+    // Gribb-Hartmann: planes are sums and differences of the matrix rows
+    const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = row3 + row0; // left
+    planes[1] = row3 - row0; // right
+    planes[2] = row3 + row1; // bottom
+    planes[3] = row3 - row1; // top
+    planes[4] = row3 + row2; // near
+    planes[5] = row3 - row2; // far
+
+    for(glm::vec4 &p : planes) {
+        p = p / glm::length(glm::vec3(p));
+    }
+}
+
+bool Frustum::Intersects(const BoundingSphere &sphere) const
+{
+    for(const glm::vec4 &p : planes) {
+        if(glm::dot(glm::vec3(p), sphere.center) + p.w < -sphere.radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+CullingStage::CullingStage()
+    : count(0),
+      visibleCount(0)
+{
+}
+
+void CullingStage::Begin()
+{
+    count = 0;
+    visibleCount = 0;
+}
+
+size_t CullingStage::Add(const BoundingSphere &sphere)
+{
+    if(count == x.size()) {
+        // keep the arrays a multiple of four so the last batch can be loaded whole
+        const size_t capacity = std::max<size_t>(16, x.size() * 2);
+        x.resize(capacity);
+        y.resize(capacity);
+        z.resize(capacity);
+        radius.resize(capacity);
+        visible.resize(capacity);
+    }
+
+    x[count] = sphere.center.x;
+    y[count] = sphere.center.y;
+    z[count] = sphere.center.z;
+    radius[count] = sphere.radius;
+    return count++;
+}
+
+void CullingStage::Run(const glm::mat4 &viewProjection)
+{
+    const Frustum frustum(viewProjection);
+    size_t i = 0;
+
+#ifdef CULLING_SSE
+    for(; i + 4 <= ((count + 3) & ~size_t(3)); i += 4) {
+        const __m128 cx = _mm_loadu_ps(&x[i]);
+        const __m128 cy = _mm_loadu_ps(&y[i]);
+        const __m128 cz = _mm_loadu_ps(&z[i]);
+        const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&radius[i]));
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for(const glm::vec4 &p : frustum.planes) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(p.x)), _mm_mul_ps(cy, _mm_set1_ps(p.y)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(cz, _mm_set1_ps(p.z)));
+            distance = _mm_add_ps(distance, _mm_set1_ps(p.w));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+
+        const int mask = _mm_movemask_ps(inside);
+        for(int k = 0; k < 4; ++k) {
+            visible[i + k] = (mask >> k) & 1;
+        }
+    }
+#endif
+
+    for(; i < count; ++i) {
+        visible[i] = frustum.Intersects(BoundingSphere{glm::vec3(x[i], y[i], z[i]), radius[i]});
+    }
+
+    visibleCount = 0;
+    for(i = 0; i < count; ++i) {
+        visibleCount += visible[i];
+    }
+}
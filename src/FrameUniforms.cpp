@@ -0,0 +1,91 @@
+#include <FrameUniforms.hpp>
+#include <RenderState.hpp>
+#include <common.h>
+
+#include <cstring>
+
+StreamAllocation writeObjectData(StreamBuffer &stream, const glm::mat4 &model, const glm::mat3 &normalMatrix,
+                                 float scale)
+{
+    StreamAllocation allocation = stream.Allocate(sizeof(ObjectData), StreamBuffer::UniformAlignment());
+    if(allocation.pointer) {
+        ObjectData object;
+        object.model = model;
+        for(int i = 0; i < 3; ++i) {
+            object.normalMatrix[i] = glm::vec4(normalMatrix[i], 0.0f);
+        }
+        object.scale = scale;
+        object.padding[0] = object.padding[1] = object.padding[2] = 0.0f;
+        std::memcpy(allocation.pointer, &object, sizeof(ObjectData));
+    }
+    return allocation;
+}
+
+FrameUniforms::FrameUniforms()
+    : frame(), lights()
+{
+}
+
+void FrameUniforms::SetCamera(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &viewPosition)
+{
+    frame.view = view;
+    frame.projection = projection;
+    frame.skyboxView = glm::mat4(glm::mat3(view));
+    frame.viewPosition = glm::vec4(viewPosition, 1.0f);
+}
+
+void FrameUniforms::ClearLights()
+{
+    lights.pointLightCount = 0;
+}
+
+void FrameUniforms::AddPointLight(const glm::vec3 &position, const glm::vec3 &ambient, const glm::vec3 &diffuse,
+                                  const glm::vec3 &specular, float constant, float linear, float quadratic)
+{
+    if(lights.pointLightCount >= MaxPointLights) {
+        std::cout << "FrameUniforms: more than " << MaxPointLights << " point lights, ignoring the rest" << std::endl;
+        return;
+    }
+
+    GpuPointLight &light = lights.pointLights[lights.pointLightCount++];
+    light.position = glm::vec4(position, 1.0f);
+    light.ambient = glm::vec4(ambient, 0.0f);
+    light.diffuse = glm::vec4(diffuse, 0.0f);
+    light.specular = glm::vec4(specular, 0.0f);
+    light.attenuation = glm::vec4(constant, linear, quadratic, 0.0f);
+}
+
+void FrameUniforms::Upload(StreamBuffer &stream)
+{
+    const StreamAllocation frameBlock = stream.Allocate(sizeof(FrameData), StreamBuffer::UniformAlignment());
+    const StreamAllocation lightBlock = stream.Allocate(sizeof(LightData), StreamBuffer::UniformAlignment());
+    if(!frameBlock.pointer || !lightBlock.pointer) {
+        return;
+    }
+
+    std::memcpy(frameBlock.pointer, &frame, sizeof(FrameData));
+    // only the lights in use, the range still covers the whole block
+    const size_t lightBytes = offsetof(LightData, pointLights) + sizeof(GpuPointLight) * lights.pointLightCount;
+    std::memcpy(lightBlock.pointer, &lights, lightBytes);
+
+    RenderState::BindUniformBufferRange(FrameDataBinding, stream.Id(), frameBlock.offset, sizeof(FrameData));
+    RenderState::BindUniformBufferRange(LightDataBinding, stream.Id(), lightBlock.offset, sizeof(LightData));
+}
+
+void FrameUniforms::BindBlocks(unsigned int program)
+{
+    const GLuint frameIndex = glGetUniformBlockIndex(program, "FrameData");
+    if(frameIndex != GL_INVALID_INDEX) {
+        GL_ERROR_CHECK(glUniformBlockBinding(program, frameIndex, FrameDataBinding));
+    }
+
+    const GLuint lightIndex = glGetUniformBlockIndex(program, "LightData");
+    if(lightIndex != GL_INVALID_INDEX) {
+        GL_ERROR_CHECK(glUniformBlockBinding(program, lightIndex, LightDataBinding));
+    }
+
+    const GLuint objectIndex = glGetUniformBlockIndex(program, "ObjectData");
+    if(objectIndex != GL_INVALID_INDEX) {
+        GL_ERROR_CHECK(glUniformBlockBinding(program, objectIndex, ObjectDataBinding));
+    }
+}
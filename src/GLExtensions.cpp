@@ -0,0 +1,83 @@
+#include <GLExtensions.hpp>
+
+#include <cstring>
+#include <iostream>
+
+bool GLExtensions::HasProgramBinary = false;
+PFNGLGETPROGRAMBINARYEXTPROC GLExtensions::GetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYEXTPROC GLExtensions::ProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIEXTPROC GLExtensions::ProgramParameteri = nullptr;
+bool GLExtensions::HasParallelShaderCompile = false;
+PFNGLMAXSHADERCOMPILERTHREADSEXTPROC GLExtensions::MaxShaderCompilerThreads = nullptr;
+bool GLExtensions::HasMultiDrawIndirect = false;
+PFNGLMULTIDRAWELEMENTSINDIRECTEXTPROC GLExtensions::MultiDrawElementsIndirect = nullptr;
+bool GLExtensions::HasBufferStorage = false;
+PFNGLBUFFERSTORAGEEXTPROC GLExtensions::BufferStorage = nullptr;
+bool GLExtensions::HasTextureCompressionS3TC = false;
+
+bool GLExtensions::Supported(const char *extension)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for(GLint i = 0; i < count; ++i) {
+        const char *name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if(name && std::strcmp(name, extension) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GLExtensions::Version(int major, int minor)
+{
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+void GLExtensions::Load(GLADloadproc loader)
+{
+    if(Version(4, 1) || Supported("GL_ARB_get_program_binary")) {
+        GetProgramBinary = (PFNGLGETPROGRAMBINARYEXTPROC)loader("glGetProgramBinary");
+        ProgramBinary = (PFNGLPROGRAMBINARYEXTPROC)loader("glProgramBinary");
+        ProgramParameteri = (PFNGLPROGRAMPARAMETERIEXTPROC)loader("glProgramParameteri");
+
+        // a driver may expose the entry points without offering any binary format
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        HasProgramBinary = GetProgramBinary && ProgramBinary && ProgramParameteri && formats > 0;
+    }
+
+    if(Supported("GL_KHR_parallel_shader_compile")) {
+        MaxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSEXTPROC)loader("glMaxShaderCompilerThreadsKHR");
+    }
+    else if(Supported("GL_ARB_parallel_shader_compile")) {
+        MaxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSEXTPROC)loader("glMaxShaderCompilerThreadsARB");
+    }
+    HasParallelShaderCompile = MaxShaderCompilerThreads != nullptr;
+    if(HasParallelShaderCompile) {
+        // let the driver pick the number of threads
+        MaxShaderCompilerThreads(0xFFFFFFFFu);
+    }
+
+    // the shading language side is only reachable through the extensions, even on 4.6 drivers they stay listed
+    if((Version(4, 3) || Supported("GL_ARB_multi_draw_indirect"))
+       && Supported("GL_ARB_shader_storage_buffer_object")
+       && Supported("GL_ARB_shader_draw_parameters")
+       && Supported("GL_ARB_shading_language_420pack")) {
+        MultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTEXTPROC)loader("glMultiDrawElementsIndirect");
+    }
+    HasMultiDrawIndirect = MultiDrawElementsIndirect != nullptr;
+
+    if(Version(4, 4) || Supported("GL_ARB_buffer_storage")) {
+        BufferStorage = (PFNGLBUFFERSTORAGEEXTPROC)loader("glBufferStorage");
+    }
+    HasBufferStorage = BufferStorage != nullptr;
+
+    HasTextureCompressionS3TC = Supported("GL_EXT_texture_compression_s3tc");
+
+    std::cout << "GL " << GLVersion.major << "." << GLVersion.minor
+              << ", program binaries: " << (HasProgramBinary ? "yes" : "no")
+              << ", parallel shader compile: " << (HasParallelShaderCompile ? "yes" : "no")
+              << ", multi-draw indirect: " << (HasMultiDrawIndirect ? "yes" : "no")
+              << ", buffer storage: " << (HasBufferStorage ? "yes" : "no")
+              << ", S3TC: " << (HasTextureCompressionS3TC ? "yes" : "no") << std::endl;
+}
@@ -0,0 +1,289 @@
+#include <GeometryArena.hpp>
+#include <common.h>
+#include <RenderState.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+FreeList::FreeList(size_t capacity)
+    : capacity(0)
+{
+    Grow(capacity);
+}
+
+bool FreeList::Allocate(size_t count, size_t &offset)
+{
+    for(auto it = blocks.begin(); it != blocks.end(); ++it) {
+        if(it->second < count) {
+            continue;
+        }
+
+        offset = it->first;
+        const size_t remaining = it->second - count;
+        blocks.erase(it);
+        if(remaining > 0) {
+            blocks[offset + count] = remaining;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void FreeList::Free(size_t offset, size_t count)
+{
+    if(count == 0) {
+        return;
+    }
+
+    auto next = blocks.lower_bound(offset);
+
+    // Merge with the following block
+    if(next != blocks.end() && offset + count == next->first) {
+        count += next->second;
+        next = blocks.erase(next);
+    }
+
+    // Merge with the preceding block
+    if(next != blocks.begin()) {
+        auto prev = std::prev(next);
+        if(prev->first + prev->second == offset) {
+            prev->second += count;
+            return;
+        }
+    }
+
+    blocks[offset] = count;
+}
+
+void FreeList::Grow(size_t newCapacity)
+{
+    if(newCapacity <= capacity) {
+        return;
+    }
+
+    const size_t oldCapacity = capacity;
+    capacity = newCapacity;
+    Free(oldCapacity, newCapacity - oldCapacity);
+}
+
+GeometryArena::GeometryArena(size_t stride, const std::vector<VertexAttribute> &attributes,
+                             size_t initialVertices, size_t initialIndexSlots)
+    : stride(stride),
+      attributes(attributes),
+      vertexSpace(initialVertices),
+      indexSpace(initialIndexSlots),
+      generation(0),
+      indexBytes(0)
+{
+    GL_ERROR_CHECK(glGenBuffers(1, &VBO));
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, VBO));
+    GL_ERROR_CHECK(glBufferData(GL_ARRAY_BUFFER, stride * initialVertices, NULL, GL_STATIC_DRAW));
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+    GL_ERROR_CHECK(glGenBuffers(1, &EBO));
+    GL_ERROR_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, EBO));
+    GL_ERROR_CHECK(glBufferData(GL_COPY_WRITE_BUFFER, sizeof(unsigned int) * initialIndexSlots, NULL, GL_STATIC_DRAW));
+    GL_ERROR_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+
+    GL_ERROR_CHECK(glGenVertexArrays(1, &VAO));
+    RenderState::BindVertexArray(VAO);
+    SetupVertexAttributes();
+}
+
+GeometryArena::~GeometryArena()
+{
+    RenderState::ForgetVertexArray(VAO);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+}
+
+void GeometryArena::SetupVertexAttributes()
+{
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, VBO));
+    GL_ERROR_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO));
+
+    for(const VertexAttribute &a : attributes) {
+        GL_ERROR_CHECK(glVertexAttribPointer(a.index, a.size, a.type, a.normalized, stride, (void*)a.offset));
+        GL_ERROR_CHECK(glEnableVertexAttribArray(a.index));
+    }
+
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+// Copies buffer into a new one of newBytes and deletes it, returns the new buffer
+unsigned int GeometryArena::resize(unsigned int buffer, size_t oldBytes, size_t newBytes)
+{
+    unsigned int resized;
+    GL_ERROR_CHECK(glGenBuffers(1, &resized));
+    GL_ERROR_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, resized));
+    GL_ERROR_CHECK(glBufferData(GL_COPY_WRITE_BUFFER, newBytes, NULL, GL_STATIC_DRAW));
+
+    if(oldBytes > 0) {
+        GL_ERROR_CHECK(glBindBuffer(GL_COPY_READ_BUFFER, buffer));
+        GL_ERROR_CHECK(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes));
+        GL_ERROR_CHECK(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    }
+
+    GL_ERROR_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    glDeleteBuffers(1, &buffer);
+    return resized;
+}
+
+void GeometryArena::growVertices(size_t minVertices)
+{
+    const size_t oldCapacity = vertexSpace.Capacity();
+    const size_t newCapacity = std::max(oldCapacity * 2, oldCapacity + minVertices);
+
+    VBO = resize(VBO, oldCapacity * stride, newCapacity * stride);
+    vertexSpace.Grow(newCapacity);
+
+    RenderState::BindVertexArray(VAO);
+    SetupVertexAttributes();
+    ++generation;
+}
+
+void GeometryArena::growIndices(size_t minSlots)
+{
+    const size_t oldCapacity = indexSpace.Capacity();
+    const size_t newCapacity = std::max(oldCapacity * 2, oldCapacity + minSlots);
+
+    EBO = resize(EBO, oldCapacity * sizeof(unsigned int), newCapacity * sizeof(unsigned int));
+    indexSpace.Grow(newCapacity);
+
+    RenderState::BindVertexArray(VAO);
+    SetupVertexAttributes();
+    ++generation;
+}
+
+size_t GeometryArena::indexSlots(unsigned int indexCount, GLenum indexType)
+{
+    const size_t bytes = indexCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+    return (bytes + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+}
+
+GeometryRange GeometryArena::Allocate(const void *vertices, unsigned int vertexCount,
+                                      const unsigned int *indices, unsigned int indexCount)
+{
+    // nothing to draw, the empty range takes no space and Free ignores it
+    if(indexCount == 0) {
+        return GeometryRange{0, 0, 0, 0, GL_UNSIGNED_SHORT};
+    }
+
+    GeometryRange range;
+    range.vertexCount = vertexCount;
+    range.indexCount = indexCount;
+    range.indexType = vertexCount <= MaxShortVertices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    size_t vertexOffset, slotOffset;
+    const size_t slots = indexSlots(indexCount, range.indexType);
+
+    if(!vertexSpace.Allocate(vertexCount, vertexOffset)) {
+        growVertices(vertexCount);
+        vertexSpace.Allocate(vertexCount, vertexOffset);
+    }
+
+    if(!indexSpace.Allocate(slots, slotOffset)) {
+        growIndices(slots);
+        indexSpace.Allocate(slots, slotOffset);
+    }
+
+    range.baseVertex = vertexOffset;
+    range.indexOffset = slotOffset * sizeof(uint32_t);
+
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, VBO));
+    GL_ERROR_CHECK(glBufferSubData(GL_ARRAY_BUFFER, vertexOffset * stride, vertexCount * stride, vertices));
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+    // Upload through the copy target so no VAO's element binding is touched
+    GL_ERROR_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, EBO));
+    if(range.indexType == GL_UNSIGNED_SHORT) {
+        std::vector<uint16_t> shortIndices(indices, indices + indexCount);
+        GL_ERROR_CHECK(glBufferSubData(GL_COPY_WRITE_BUFFER, range.indexOffset,
+                                       indexCount * sizeof(uint16_t), shortIndices.data()));
+        indexBytes += indexCount * sizeof(uint16_t);
+    }
+    else {
+        GL_ERROR_CHECK(glBufferSubData(GL_COPY_WRITE_BUFFER, range.indexOffset,
+                                       indexCount * sizeof(uint32_t), indices));
+        indexBytes += indexCount * sizeof(uint32_t);
+    }
+    GL_ERROR_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+
+    return range;
+}
+
+std::vector<GeometryRange> GeometryArena::AllocateSplit(const void *vertices, unsigned int vertexCount,
+                                                        const unsigned int *indices, unsigned int indexCount)
+{
+    if(vertexCount <= MaxShortVertices) {
+        return {Allocate(vertices, vertexCount, indices, indexCount)};
+    }
+
+    // Walk the triangles in order and start a new chunk whenever the next one
+    // would push the chunk past MaxShortVertices, shared vertices are duplicated
+    const unsigned int unmapped = ~0u;
+    const unsigned char *source = (const unsigned char*)vertices;
+    std::vector<unsigned int> remap(vertexCount, unmapped);
+    std::vector<unsigned int> chunkSources;
+    std::vector<unsigned char> chunkVertices;
+    std::vector<unsigned int> chunkIndices;
+    std::vector<GeometryRange> ranges;
+
+    auto flush = [&]() {
+        if(chunkIndices.empty()) {
+            return;
+        }
+        ranges.push_back(Allocate(chunkVertices.data(), chunkSources.size(), chunkIndices.data(), chunkIndices.size()));
+        for(unsigned int v : chunkSources) {
+            remap[v] = unmapped;
+        }
+        chunkSources.clear();
+        chunkVertices.clear();
+        chunkIndices.clear();
+    };
+
+    for(unsigned int t = 0; t + 2 < indexCount; t += 3) {
+        unsigned int added = 0;
+        for(int k = 0; k < 3; ++k) {
+            added += remap[indices[t + k]] == unmapped;
+        }
+
+        if(chunkSources.size() + added > MaxShortVertices) {
+            flush();
+        }
+
+        for(int k = 0; k < 3; ++k) {
+            const unsigned int v = indices[t + k];
+            if(remap[v] == unmapped) {
+                remap[v] = chunkSources.size();
+                chunkSources.push_back(v);
+                chunkVertices.insert(chunkVertices.end(), source + v * stride, source + (v + 1) * stride);
+            }
+            chunkIndices.push_back(remap[v]);
+        }
+    }
+    flush();
+
+    return ranges;
+}
+
+void GeometryArena::Free(const GeometryRange &range)
+{
+    vertexSpace.Free(range.baseVertex, range.vertexCount);
+    indexSpace.Free(range.indexOffset / sizeof(uint32_t), indexSlots(range.indexCount, range.indexType));
+    indexBytes -= range.indexCount * (range.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+}
+
+void GeometryArena::Bind()
+{
+    RenderState::BindVertexArray(VAO);
+}
+
+void GeometryArena::Draw(const GeometryRange &range)
+{
+    GL_ERROR_CHECK(glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, range.indexType,
+                                            (void*)range.indexOffset, range.baseVertex));
+}
@@ -0,0 +1,193 @@
+#include <ImageDecodePool.hpp>
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+bool ImageDecodePool::Verbose = true;
+
+namespace {
+    void flipRows(unsigned char *pixels, int width, int height, int channels)
+    {
+        const size_t stride = (size_t)width * channels;
+        std::vector<unsigned char> row(stride);
+        for(int top = 0, bottom = height - 1; top < bottom; ++top, --bottom) {
+            unsigned char *a = pixels + top * stride, *b = pixels + bottom * stride;
+            std::memcpy(&row[0], a, stride);
+            std::memcpy(a, b, stride);
+            std::memcpy(b, &row[0], stride);
+        }
+    }
+
+    // Box filters pixels to the size of the next mip level (odd sizes round down, as GL does)
+    // and replaces them, the result is allocated like stb_image's own so it is freed the same way
+    unsigned char* halve(unsigned char *pixels, int &width, int &height, int channels)
+    {
+        const int halfWidth = std::max(width / 2, 1), halfHeight = std::max(height / 2, 1);
+        unsigned char *half = (unsigned char*)std::malloc((size_t)halfWidth * halfHeight * channels);
+        for(int y = 0; y < halfHeight; ++y) {
+            const int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+            for(int x = 0; x < halfWidth; ++x) {
+                const int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+                for(int c = 0; c < channels; ++c) {
+                    const int sum = pixels[((size_t)y0 * width + x0) * channels + c]
+                                    + pixels[((size_t)y0 * width + x1) * channels + c]
+                                    + pixels[((size_t)y1 * width + x0) * channels + c]
+                                    + pixels[((size_t)y1 * width + x1) * channels + c];
+                    half[((size_t)y * halfWidth + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+        stbi_image_free(pixels);
+        width = halfWidth;
+        height = halfHeight;
+        return half;
+    }
+}
+
+ImageDecodePool::ImageDecodePool(unsigned int threadCount)
+    : pending(0),
+      stopping(false),
+      decoded(0),
+      decodeSeconds(0.0)
+{
+    if(threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    for(unsigned int i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ImageDecodePool::work, this);
+    }
+}
+
+ImageDecodePool::~ImageDecodePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    jobReady.notify_all();
+    for(std::thread &worker : workers) {
+        worker.join();
+    }
+    // decoded but never uploaded
+    for(Result &result : results) {
+        stbi_image_free(result.image.pixels);
+    }
+}
+
+ImageDecodePool& ImageDecodePool::Shared()
+{
+    static ImageDecodePool pool;
+    return pool;
+}
+
+void ImageDecodePool::Decode(const std::string &path, bool flipVertically, ImageUpload upload, unsigned int halvings)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(Job{path, flipVertically, halvings, std::move(upload)});
+        ++pending;
+    }
+    jobReady.notify_one();
+}
+
+void ImageDecodePool::work()
+{
+    for(;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if(stopping) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        Result result;
+        result.image.path = job.path;
+        result.image.pixels = stbi_load(job.path.c_str(), &result.image.width, &result.image.height,
+                                        &result.image.channels, 0);
+        if(result.image.pixels && job.flipVertically) {
+            flipRows(result.image.pixels, result.image.width, result.image.height, result.image.channels);
+        }
+        for(unsigned int i = 0; result.image.pixels && i < job.halvings; ++i) {
+            result.image.pixels = halve(result.image.pixels, result.image.width, result.image.height,
+                                        result.image.channels);
+        }
+        result.image.decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.upload = std::move(job.upload);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(std::move(result));
+        }
+        resultReady.notify_one();
+    }
+}
+
+void ImageDecodePool::FreePixels(unsigned char *pixels)
+{
+    stbi_image_free(pixels);
+}
+
+void ImageDecodePool::upload(Result &result)
+{
+    DecodedImage &image = result.image;
+    if(!image.pixels) {
+        std::cout << "ERROR::IMAGE_DECODE_POOL: failed to decode " << image.path << std::endl;
+    }
+    else if(Verbose) {
+        std::cout << "Decoded " << image.path << " (" << image.width << "x" << image.height << ", "
+                  << image.channels << " channels) in " << image.decodeSeconds * 1000 << " ms" << std::endl;
+    }
+
+    ++decoded;
+    decodeSeconds += image.decodeSeconds;
+
+    // a failed decode still reaches the callback, it decides what the texture falls back to
+    result.upload(image);
+    stbi_image_free(image.pixels);
+}
+
+unsigned int ImageDecodePool::Poll()
+{
+    for(;;) {
+        Result result;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(results.empty()) {
+                return pending;
+            }
+            result = std::move(results.front());
+            results.pop_front();
+            --pending;
+        }
+        upload(result);
+    }
+}
+
+void ImageDecodePool::Finish()
+{
+    for(;;) {
+        Result result;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if(pending == 0) {
+                return;
+            }
+            resultReady.wait(lock, [this]() { return !results.empty(); });
+            result = std::move(results.front());
+            results.pop_front();
+            --pending;
+        }
+        upload(result);
+    }
+}
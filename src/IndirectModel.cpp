@@ -0,0 +1,337 @@
+#include <IndirectModel.hpp>
+#include <GLExtensions.hpp>
+#include <RenderState.hpp>
+#include <TextureStreamer.hpp>
+#include <common.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace {
+    // texture units of the two arrays, shared by both paths
+    const unsigned int DiffuseUnit = 0, SpecularUnit = 1;
+
+    // Adds each distinct texture once, missing ones point at a fill layer that is added on demand.
+    // Sources still streaming hold their placeholder, they are copied again when their image is in.
+    std::vector<int> addLayers(TextureArray &array, const std::vector<unsigned int> &sources, const glm::vec4 &fill,
+                               bool &mipmapsDirty)
+    {
+        std::map<unsigned int, int> layerOf;
+        std::vector<int> layers;
+        for(unsigned int source : sources) {
+            auto it = layerOf.find(source);
+            if(it == layerOf.end()) {
+                const int layer = source ? array.Add(source) : array.AddColor(fill);
+                it = layerOf.insert({source, layer}).first;
+                TextureArray *target = &array;
+                bool *dirty = &mipmapsDirty;
+                TextureStreamer::Shared().WhenReady(source, [target, layer, dirty](unsigned int texture, bool) {
+                    target->Replace(layer, texture);
+                    *dirty = true;
+                });
+            }
+            layers.push_back(it->second);
+        }
+        array.GenerateMipmaps();
+        return layers;
+    }
+
+    std::unique_ptr<TextureArray> makeArray(const std::vector<unsigned int> &sources)
+    {
+        std::vector<unsigned int> distinct(sources);
+        std::sort(distinct.begin(), distinct.end());
+        distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+        glm::ivec2 size(1);
+        for(unsigned int source : distinct) {
+            // the size of a streaming texture is not known yet, it gets the largest layer
+            if(TextureStreamer::Shared().IsPending(source)) {
+                size = glm::ivec2(IndirectModel::MaxLayerSize);
+            }
+            else if(source) {
+                size = glm::max(size, TextureArray::SizeOf(source));
+            }
+        }
+        size = glm::min(size, glm::ivec2(IndirectModel::MaxLayerSize));
+        return std::unique_ptr<TextureArray>(new TextureArray(size.x, size.y, distinct.size()));
+    }
+}
+
+IndirectModel::IndirectModel(const std::vector<Mesh> &meshes, StreamBuffer &stream, bool doubleSided)
+    : doubleSided(doubleSided),
+      stream(stream),
+      commandsDirty(true),
+      instanceOffset(0),
+      instanceBytes(0),
+      indexOffset(0),
+      indexBytes(0),
+      drawCalls(0),
+      visibleDraws(0),
+      mipmapsDirty(false),
+      handlesProgram(0),
+      queuedShader(nullptr)
+{
+    std::vector<int> diffuseLayers, specularLayers;
+    buildTextures(meshes, diffuseLayers, specularLayers);
+
+    glm::vec3 center(0.0f);
+    for(const Mesh &mesh : meshes) {
+        center += mesh.boundingSphere.center;
+    }
+    bounds.center = meshes.empty() ? center : center / (float)meshes.size();
+    bounds.radius = 0.0f;
+
+    for(size_t i = 0; i < meshes.size(); ++i) {
+        const Mesh &mesh = meshes[i];
+        meshBounds.push_back(mesh.boundingSphere);
+        bounds.radius = std::max(bounds.radius, glm::length(mesh.boundingSphere.center - bounds.center)
+                                                + mesh.boundingSphere.radius);
+
+        IndirectDrawData draw;
+        draw.positionOffset = glm::vec4(mesh.bounds.positionOffset, 0.0f);
+        draw.positionScale = glm::vec4(mesh.bounds.positionScale, 0.0f);
+        draw.texCoordTransform = glm::vec4(mesh.bounds.texCoordOffset, mesh.bounds.texCoordScale);
+        draw.diffuseLayer = diffuseLayers[i];
+        draw.specularLayer = specularLayers[i];
+        draw.shininess = mesh.material.Shininess();
+        draw.padding = 0.0f;
+
+        for(const GeometryRange &range : mesh.ranges) {
+            // every range has one index type for the whole multi-draw, AllocateSplit keeps meshes on 16 bit
+            if(range.indexType != GL_UNSIGNED_SHORT) {
+                std::cout << "ERROR::INDIRECT_MODEL: skipping a range with 32 bit indices" << std::endl;
+                continue;
+            }
+            commands.push_back(DrawElementsIndirectCommand{range.indexCount, 0,
+                                                           (GLuint)(range.indexOffset / sizeof(GLushort)),
+                                                           (GLint)range.baseVertex, 0});
+            draws.push_back(draw);
+            commandMesh.push_back(i);
+        }
+    }
+
+    GL_ERROR_CHECK(glGenBuffers(1, &commandBuffer));
+    GL_ERROR_CHECK(glGenBuffers(1, &drawBuffer));
+
+    if(GLExtensions::HasMultiDrawIndirect && !draws.empty()) {
+        GL_ERROR_CHECK(glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawBuffer));
+        GL_ERROR_CHECK(glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(IndirectDrawData) * draws.size(), &draws[0],
+                                    GL_STATIC_DRAW));
+        GL_ERROR_CHECK(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    }
+}
+
+IndirectModel::~IndirectModel()
+{
+    glDeleteBuffers(1, &commandBuffer);
+    glDeleteBuffers(1, &drawBuffer);
+}
+
+void IndirectModel::buildTextures(const std::vector<Mesh> &meshes, std::vector<int> &diffuseLayers,
+                                  std::vector<int> &specularLayers)
+{
+    std::vector<unsigned int> diffuseSources, specularSources;
+    for(const Mesh &mesh : meshes) {
+        diffuseSources.push_back(mesh.material.TextureOf(DiffuseSlot));
+        specularSources.push_back(mesh.material.TextureOf(SpecularSlot));
+    }
+
+    // untextured meshes keep their lighting: white albedo, no highlights
+    diffuseTextures = makeArray(diffuseSources);
+    diffuseLayers = addLayers(*diffuseTextures, diffuseSources, glm::vec4(1.0f), mipmapsDirty);
+    specularTextures = makeArray(specularSources);
+    specularLayers = addLayers(*specularTextures, specularSources, glm::vec4(0.0f), mipmapsDirty);
+}
+
+void IndirectModel::SetupSamplers(Shader &shader)
+{
+    shader.use();
+    shader.setInt("diffuseTextures", DiffuseUnit);
+    shader.setInt("specularTextures", SpecularUnit);
+}
+
+void IndirectModel::Begin()
+{
+    instances.clear();
+    visibility.clear();
+    instanceBytes = 0;
+    visibleDraws = 0;
+}
+
+void IndirectModel::AddInstance(const glm::mat4 &model, const unsigned char *visible)
+{
+    if(visible && std::count(visible, visible + meshBounds.size(), 0) == (long)meshBounds.size()) {
+        return;
+    }
+    instances.push_back(model);
+    for(size_t mesh = 0; mesh < meshBounds.size(); ++mesh) {
+        visibility.push_back(visible ? visible[mesh] : 1);
+    }
+}
+
+size_t IndirectModel::AddBounds(CullingStage &culling, const glm::mat4 &model) const
+{
+    const size_t first = culling.Size();
+    for(const BoundingSphere &sphere : meshBounds) {
+        culling.Add(transformSphere(sphere, model));
+    }
+    return first;
+}
+
+void IndirectModel::compact()
+{
+    instanceIndices.assign(commands.size(), 0);
+    visibleDraws = 0;
+    for(size_t i = 0; i < commands.size(); ++i) {
+        instanceIndices[i] = instanceIndices.size();
+        for(size_t instance = 0; instance < instances.size(); ++instance) {
+            if(visibility[instance * meshBounds.size() + commandMesh[i]]) {
+                instanceIndices.push_back(instance);
+            }
+        }
+        const GLuint count = instanceIndices.size() - instanceIndices[i];
+        if(commands[i].instanceCount != count) {
+            commands[i].instanceCount = count;
+            commandsDirty = true;
+        }
+        visibleDraws += count;
+    }
+}
+
+void IndirectModel::Upload()
+{
+    compact();
+    // the fallback path sets the matrices as uniforms
+    if(!GLExtensions::HasMultiDrawIndirect || instances.empty()) {
+        return;
+    }
+
+    const StreamAllocation allocation = stream.Allocate(sizeof(glm::mat4) * instances.size(),
+                                                        StreamBuffer::StorageAlignment());
+    const StreamAllocation indices = stream.Allocate(sizeof(GLuint) * instanceIndices.size(),
+                                                     StreamBuffer::StorageAlignment());
+    if(!allocation.pointer || !indices.pointer) {
+        return;
+    }
+    std::memcpy(allocation.pointer, &instances[0], sizeof(glm::mat4) * instances.size());
+    instanceOffset = allocation.offset;
+    instanceBytes = sizeof(glm::mat4) * instances.size();
+    std::memcpy(indices.pointer, &instanceIndices[0], sizeof(GLuint) * instanceIndices.size());
+    indexOffset = indices.offset;
+    indexBytes = sizeof(GLuint) * instanceIndices.size();
+
+    // the instance counts are the only thing in the commands that changes
+    if(commandsDirty) {
+        GL_ERROR_CHECK(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer));
+        GL_ERROR_CHECK(glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * commands.size(),
+                                    &commands[0], GL_DYNAMIC_DRAW));
+        GL_ERROR_CHECK(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+        commandsDirty = false;
+    }
+}
+
+void IndirectModel::Draw(Shader &shader)
+{
+    drawCalls = 0;
+    if(instances.empty() || commands.empty()) {
+        return;
+    }
+
+    shader.use();
+    RenderState::SetCullFace(!doubleSided, GL_BACK);
+    RenderState::BindTexture(DiffuseUnit, GL_TEXTURE_2D_ARRAY, diffuseTextures->Id());
+    RenderState::BindTexture(SpecularUnit, GL_TEXTURE_2D_ARRAY, specularTextures->Id());
+    MeshArena().Bind();
+
+    if(GLExtensions::HasMultiDrawIndirect) {
+        drawIndirect();
+    }
+    else {
+        drawFallback(shader);
+    }
+}
+
+void IndirectModel::drawIndirect()
+{
+    if(instanceBytes == 0) {
+        return;
+    }
+
+    GL_ERROR_CHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DrawDataBinding, drawBuffer));
+    GL_ERROR_CHECK(glBindBufferRange(GL_SHADER_STORAGE_BUFFER, InstanceDataBinding, stream.Id(), instanceOffset,
+                                     instanceBytes));
+    GL_ERROR_CHECK(glBindBufferRange(GL_SHADER_STORAGE_BUFFER, InstanceIndexBinding, stream.Id(), indexOffset,
+                                     indexBytes));
+    GL_ERROR_CHECK(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer));
+
+    GL_ERROR_CHECK(GLExtensions::MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, commands.size(), 0));
+    ++drawCalls;
+
+    GL_ERROR_CHECK(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+}
+
+// GL 3.3: the same commands, one glDrawElementsBaseVertex per visible instance each, with DrawData in uniforms
+void IndirectModel::drawFallback(Shader &shader)
+{
+    if(handlesProgram != shader.ID) {
+        modelHandle = shader.GetUniform("model");
+        positionOffsetHandle = shader.GetUniform("draw.positionOffset");
+        positionScaleHandle = shader.GetUniform("draw.positionScale");
+        texCoordTransformHandle = shader.GetUniform("draw.texCoordTransform");
+        diffuseLayerHandle = shader.GetUniform("draw.diffuseLayer");
+        specularLayerHandle = shader.GetUniform("draw.specularLayer");
+        shininessHandle = shader.GetUniform("draw.shininess");
+        handlesProgram = shader.ID;
+    }
+
+    for(size_t instance = 0; instance < instances.size(); ++instance) {
+        shader.setMat4(modelHandle, instances[instance]);
+        for(size_t i = 0; i < commands.size(); ++i) {
+            if(!visibility[instance * meshBounds.size() + commandMesh[i]]) {
+                continue;
+            }
+            const DrawElementsIndirectCommand &command = commands[i];
+            const IndirectDrawData &draw = draws[i];
+            shader.setVec4(positionOffsetHandle, draw.positionOffset);
+            shader.setVec4(positionScaleHandle, draw.positionScale);
+            shader.setVec4(texCoordTransformHandle, draw.texCoordTransform);
+            shader.setInt(diffuseLayerHandle, draw.diffuseLayer);
+            shader.setInt(specularLayerHandle, draw.specularLayer);
+            shader.setFloat(shininessHandle, draw.shininess);
+
+            GL_ERROR_CHECK(glDrawElementsBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_SHORT,
+                                                    (void*)(command.firstIndex * sizeof(GLushort)),
+                                                    command.baseVertex));
+            ++drawCalls;
+        }
+    }
+}
+
+void IndirectModel::Queue(RenderQueue &queue, Shader &shader, const glm::vec3 &cameraPosition)
+{
+    if(instances.empty()) {
+        return;
+    }
+    queuedShader = &shader;
+    Upload();
+
+    if(mipmapsDirty) {
+        diffuseTextures->GenerateMipmaps();
+        specularTextures->GenerateMipmaps();
+        mipmapsDirty = false;
+    }
+
+    float depth = glm::length(glm::vec3(instances[0] * glm::vec4(bounds.center, 1.0f)) - cameraPosition);
+    for(const glm::mat4 &instance : instances) {
+        depth = std::min(depth, glm::length(glm::vec3(instance * glm::vec4(bounds.center, 1.0f)) - cameraPosition));
+    }
+    queue.Submit(queue.Key(OpaquePass, BlendNone, shader.ID, diffuseTextures->Id(), depth),
+                 &IndirectModel::drawPacket, this);
+}
+
+void IndirectModel::drawPacket(void *object, unsigned int first, unsigned int count)
+{
+    IndirectModel &model = *(IndirectModel*)object;
+    model.Draw(*model.queuedShader);
+}
@@ -0,0 +1,201 @@
+#include <KtxFile.hpp>
+#include <GLExtensions.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace {
+    const unsigned char Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+    const uint32_t NativeEndianness = 0x04030201;
+
+    struct Header
+    {
+        uint32_t endianness;
+        uint32_t glType, glTypeSize, glFormat;
+        uint32_t glInternalFormat, glBaseInternalFormat;
+        uint32_t pixelWidth, pixelHeight, pixelDepth;
+        uint32_t numberOfArrayElements, numberOfFaces, numberOfMipmapLevels;
+        uint32_t bytesOfKeyValueData;
+    };
+
+    size_t padding(size_t bytes)
+    {
+        return (4 - bytes % 4) % 4;
+    }
+
+    const char OrientationKey[] = "KTXorientation";
+
+    // Reads KTXorientation out of the key/value data, each pair is its size, "key\0value\0" and padding
+    KtxFile::Orientation readOrientation(const std::vector<char> &keyValues)
+    {
+        size_t offset = 0;
+        while(offset + sizeof(uint32_t) <= keyValues.size()) {
+            uint32_t size = 0;
+            std::memcpy(&size, &keyValues[offset], sizeof(size));
+            offset += sizeof(size);
+            if(size > keyValues.size() - offset) {
+                break;
+            }
+            const std::string pair(&keyValues[offset], size);
+            const std::string::size_type end = pair.find('\0');
+            if(end != std::string::npos && pair.compare(0, end, OrientationKey) == 0) {
+                const std::string value = pair.substr(end + 1);
+                if(value.find("T=u") != std::string::npos) {
+                    return KtxFile::OrientationUp;
+                }
+                if(value.find("T=d") != std::string::npos) {
+                    return KtxFile::OrientationDown;
+                }
+            }
+            offset += size + padding(size);
+        }
+        return KtxFile::OrientationUnknown;
+    }
+}
+
+std::string KtxFile::BakedPath(const std::string &imagePath)
+{
+    const std::string::size_type dot = imagePath.find_last_of('.');
+    const std::string::size_type slash = imagePath.find_last_of('/');
+    if(dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return imagePath + ".ktx";
+    }
+    return imagePath.substr(0, dot) + ".ktx";
+}
+
+size_t KtxFile::BlockBytes(GLenum internalFormat)
+{
+    switch(internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return 8;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return 16;
+        default: return 0;
+    }
+}
+
+size_t KtxFile::LevelSize(unsigned int level) const
+{
+    return (size_t)((LevelWidth(level) + 3) / 4) * ((LevelHeight(level) + 3) / 4) * BlockBytes(internalFormat);
+}
+
+bool KtxFile::Read(const std::string &path, bool headerOnly)
+{
+    data.clear();
+    std::ifstream file(path, std::ios::binary);
+    if(!file) {
+        return false;
+    }
+
+    unsigned char identifier[12];
+    Header header;
+    if(!file.read((char*)identifier, sizeof(identifier)) || std::memcmp(identifier, Identifier, sizeof(identifier)) != 0
+       || !file.read((char*)&header, sizeof(header)) || header.endianness != NativeEndianness) {
+        return false;
+    }
+    // compressed (glType 0), 2D, not an array
+    if(header.glType != 0 || header.pixelDepth > 1 || header.numberOfArrayElements > 0
+       || (header.numberOfFaces != 1 && header.numberOfFaces != 6)) {
+        return false;
+    }
+
+    internalFormat = header.glInternalFormat;
+    baseInternalFormat = header.glBaseInternalFormat;
+    width = header.pixelWidth;
+    height = header.pixelHeight;
+    faces = header.numberOfFaces;
+    if(width == 0 || height == 0 || BlockBytes(internalFormat) == 0) {
+        return false;
+    }
+    // the key/value data is small, anything claiming more is not a file the baker wrote
+    if(header.bytesOfKeyValueData > (1 << 16)) {
+        return false;
+    }
+    std::vector<char> keyValues(header.bytesOfKeyValueData);
+    if(!keyValues.empty() && !file.read(&keyValues[0], keyValues.size())) {
+        return false;
+    }
+    orientation = readOrientation(keyValues);
+    if(headerOnly) {
+        return true;
+    }
+
+    // a chain longer than the full one would be levels of 1x1, never written by the baker
+    unsigned int fullLevels = 1;
+    while((std::max(width, height) >> fullLevels) > 0) {
+        ++fullLevels;
+    }
+    const unsigned int levels = std::min(header.numberOfMipmapLevels ? header.numberOfMipmapLevels : 1, fullLevels);
+    data.resize(levels);
+    for(unsigned int level = 0; level < levels; ++level) {
+        uint32_t imageSize = 0;
+        if(!file.read((char*)&imageSize, sizeof(imageSize))) {
+            data.clear();
+            return false;
+        }
+        // for non-array cube maps imageSize is one face, whatever it says the size follows from the dimensions
+        const size_t faceSize = LevelSize(level);
+        if(imageSize != faceSize) {
+            data.clear();
+            return false;
+        }
+        data[level].resize(faces);
+        for(unsigned int face = 0; face < faces; ++face) {
+            data[level][face].resize(faceSize);
+            if(!file.read((char*)&data[level][face][0], faceSize)) {
+                data.clear();
+                return false;
+            }
+            file.seekg(padding(faceSize), std::ios::cur);
+        }
+    }
+    return true;
+}
+
+bool KtxFile::Write(const std::string &path) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if(!file) {
+        return false;
+    }
+
+    Header header;
+    header.endianness = NativeEndianness;
+    header.glType = 0;
+    header.glTypeSize = 1;
+    header.glFormat = 0;
+    header.glInternalFormat = internalFormat;
+    header.glBaseInternalFormat = baseInternalFormat;
+    header.pixelWidth = width;
+    header.pixelHeight = height;
+    header.pixelDepth = 0;
+    header.numberOfArrayElements = 0;
+    header.numberOfFaces = faces;
+    header.numberOfMipmapLevels = data.size();
+    const char zeros[4] = {};
+    std::string orientationPair;
+    if(orientation != OrientationUnknown) {
+        orientationPair = std::string(OrientationKey) + '\0' + (orientation == OrientationUp ? "S=r,T=u" : "S=r,T=d") + '\0';
+    }
+    const uint32_t pairSize = orientationPair.size();
+    header.bytesOfKeyValueData = orientationPair.empty() ? 0 : sizeof(pairSize) + pairSize + padding(pairSize);
+
+    file.write((const char*)Identifier, sizeof(Identifier));
+    file.write((const char*)&header, sizeof(header));
+    if(!orientationPair.empty()) {
+        file.write((const char*)&pairSize, sizeof(pairSize));
+        file.write(orientationPair.data(), pairSize);
+        file.write(zeros, padding(pairSize));
+    }
+
+    for(const std::vector<std::vector<unsigned char>> &level : data) {
+        const size_t faceSize = level[0].size();
+        const uint32_t imageSize = faces == 6 ? faceSize : faceSize * faces;
+        file.write((const char*)&imageSize, sizeof(imageSize));
+        for(const std::vector<unsigned char> &face : level) {
+            file.write((const char*)&face[0], face.size());
+            file.write(zeros, padding(face.size()));
+        }
+    }
+    return (bool)file;
+}
@@ -0,0 +1,38 @@
+#include <Material.hpp>
+
+namespace {
+    // The assimp texture type names model.h gives the textures it loads
+    const char *SlotNames[TextureSlotCount] = {
+        "texture_diffuse", "texture_specular", "texture_normal", "texture_height"
+    };
+}
+
+TextureSlot textureSlotOf(const std::string &type)
+{
+    for(int slot = 0; slot < TextureSlotCount; ++slot) {
+        if(type == SlotNames[slot]) {
+            return (TextureSlot)slot;
+        }
+    }
+    return TextureSlotCount;
+}
+
+Material::Material()
+    : shininess(32.0f)
+{
+    for(int slot = 0; slot < TextureSlotCount; ++slot) {
+        textures[slot] = 0;
+    }
+}
+
+void Material::SetTexture(TextureSlot slot, unsigned int texture)
+{
+    if(slot < TextureSlotCount && textures[slot] == 0) {
+        textures[slot] = texture;
+    }
+}
+
+void Material::SetShininess(float shininess)
+{
+    this->shininess = shininess;
+}
@@ -0,0 +1,263 @@
+#include <MeshOptimizer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                    unsigned int cacheSize)
+{
+    VertexCacheStats stats = {0, 0};
+    if(indices.empty() || vertexCount == 0) {
+        return stats;
+    }
+
+    // FIFO cache, timestamps tell whether a vertex is still among the last cacheSize misses
+    std::vector<unsigned int> insertedAt(vertexCount, 0);
+    unsigned int misses = 0;
+
+    for(unsigned int index : indices) {
+        if(insertedAt[index] == 0 || misses - insertedAt[index] >= cacheSize) {
+            ++misses;
+            insertedAt[index] = misses;
+        }
+    }
+
+    stats.acmr = 1.0f * misses / (indices.size() / 3);
+    stats.atvr = 1.0f * misses / vertexCount;
+    return stats;
+}
+
+// Forsyth's tuning, see "Linear-Speed Vertex Cache Optimisation"
+static const int ForsythCacheSize = 32;
+
+static float forsythScore(int cachePosition, unsigned int remainingValence)
+{
+    if(remainingValence == 0) {
+        return -1;
+    }
+
+    float score = 0;
+    if(cachePosition >= 0) {
+        if(cachePosition < 3) {
+            // the last triangle's vertices get a fixed score so it isn't immediately reused
+            score = 0.75f;
+        }
+        else {
+            score = std::pow(1.0f - (cachePosition - 3) / float(ForsythCacheSize - 3), 1.5f);
+        }
+    }
+
+    // favour vertices with few triangles left so they are finished off
+    score += 2.0f * std::pow((float)remainingValence, -0.5f);
+    return score;
+}
+
+void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if(triangleCount == 0) {
+        return;
+    }
+
+    // triangles adjacent to every vertex, the first remaining[v] entries are not emitted yet
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for(unsigned int index : indices) {
+        ++remaining[index];
+    }
+
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for(size_t v = 0; v < vertexCount; ++v) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> filled(vertexCount, 0);
+    for(size_t t = 0; t < triangleCount; ++t) {
+        for(int k = 0; k < 3; ++k) {
+            const unsigned int v = indices[t*3 + k];
+            adjacency[offsets[v] + filled[v]++] = t;
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for(size_t v = 0; v < vertexCount; ++v) {
+        vertexScore[v] = forsythScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int best = 0;
+    for(size_t t = 0; t < triangleCount; ++t) {
+        triangleScore[t] = vertexScore[indices[t*3]] + vertexScore[indices[t*3 + 1]] + vertexScore[indices[t*3 + 2]];
+        if(triangleScore[t] > triangleScore[best]) {
+            best = t;
+        }
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    std::vector<unsigned int> cache, newCache;
+    size_t scanCursor = 0;
+
+    while(result.size() < indices.size()) {
+        // nothing in the cache has triangles left, continue with the next unemitted one
+        if(best < 0) {
+            while(emitted[scanCursor]) {
+                ++scanCursor;
+            }
+            best = scanCursor;
+        }
+
+        const unsigned int *triangle = &indices[best*3];
+        emitted[best] = true;
+        result.insert(result.end(), triangle, triangle + 3);
+
+        for(int k = 0; k < 3; ++k) {
+            const unsigned int v = triangle[k];
+            unsigned int *begin = &adjacency[offsets[v]];
+            unsigned int *end = begin + remaining[v];
+            unsigned int *found = std::find(begin, end, (unsigned int)best);
+            if(found != end) {
+                std::swap(*found, *(end - 1));
+                --remaining[v];
+            }
+        }
+
+        // the triangle's vertices move to the front of the cache
+        newCache.clear();
+        for(int k = 0; k < 3; ++k) {
+            if(std::find(newCache.begin(), newCache.end(), triangle[k]) == newCache.end()) {
+                newCache.push_back(triangle[k]);
+            }
+        }
+        for(unsigned int v : cache) {
+            if(v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                newCache.push_back(v);
+            }
+        }
+
+        for(size_t i = 0; i < newCache.size(); ++i) {
+            const unsigned int v = newCache[i];
+            cachePosition[v] = i < (size_t)ForsythCacheSize ? (int)i : -1;
+            vertexScore[v] = forsythScore(cachePosition[v], remaining[v]);
+        }
+
+        // only triangles touching the cache changed score
+        best = -1;
+        float bestScore = -1;
+        for(unsigned int v : newCache) {
+            for(unsigned int i = 0; i < remaining[v]; ++i) {
+                const unsigned int t = adjacency[offsets[v] + i];
+                const float score = vertexScore[indices[t*3]] + vertexScore[indices[t*3 + 1]] + vertexScore[indices[t*3 + 2]];
+                triangleScore[t] = score;
+                if(score > bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+
+        if(newCache.size() > (size_t)ForsythCacheSize) {
+            newCache.resize(ForsythCacheSize);
+        }
+        cache.swap(newCache);
+    }
+
+    indices.swap(result);
+}
+
+void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<glm::vec3> &positions)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if(triangleCount == 0) {
+        return;
+    }
+
+    // Split into clusters where all three vertices of a triangle miss a 16 entry FIFO cache,
+    // reordering whole clusters keeps the transform cost of the cache optimized order.
+    const unsigned int cacheSize = 16;
+    std::vector<unsigned int> insertedAt(positions.size(), 0);
+    unsigned int misses = 0;
+    std::vector<size_t> clusterStarts;
+
+    for(size_t t = 0; t < triangleCount; ++t) {
+        int triangleMisses = 0;
+        for(int k = 0; k < 3; ++k) {
+            const unsigned int v = indices[t*3 + k];
+            if(insertedAt[v] == 0 || misses - insertedAt[v] >= cacheSize) {
+                ++misses;
+                insertedAt[v] = misses;
+                ++triangleMisses;
+            }
+        }
+
+        if(t == 0 || triangleMisses == 3) {
+            clusterStarts.push_back(t);
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0;
+    std::vector<glm::vec3> clusterCentroid(clusterStarts.size() - 1, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormal(clusterStarts.size() - 1, glm::vec3(0.0f));
+
+    for(size_t c = 0; c + 1 < clusterStarts.size(); ++c) {
+        float clusterArea = 0;
+        for(size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+            const glm::vec3 &a = positions[indices[t*3]];
+            const glm::vec3 &b = positions[indices[t*3 + 1]];
+            const glm::vec3 &d = positions[indices[t*3 + 2]];
+
+            // area weighted normal and centroid
+            const glm::vec3 n = glm::cross(b - a, d - a);
+            const float area = glm::length(n);
+            clusterNormal[c] += n;
+            clusterCentroid[c] += (a + b + d) * (area / 3);
+            clusterArea += area;
+        }
+
+        meshCentroid += clusterCentroid[c];
+        meshArea += clusterArea;
+        if(clusterArea > 0) {
+            clusterCentroid[c] /= clusterArea;
+        }
+        const float normalLength = glm::length(clusterNormal[c]);
+        if(normalLength > 0) {
+            clusterNormal[c] /= normalLength;
+        }
+    }
+
+    if(meshArea > 0) {
+        meshCentroid /= meshArea;
+    }
+
+    // clusters facing away from the center and far from it occlude the rest, draw them first
+    std::vector<float> sortKey(clusterStarts.size() - 1);
+    std::vector<size_t> order(clusterStarts.size() - 1);
+    for(size_t c = 0; c < order.size(); ++c) {
+        sortKey[c] = glm::dot(clusterCentroid[c] - meshCentroid, clusterNormal[c]);
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&sortKey](size_t a, size_t b) {
+        return sortKey[a] > sortKey[b];
+    });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for(size_t c : order) {
+        result.insert(result.end(), indices.begin() + clusterStarts[c]*3, indices.begin() + clusterStarts[c + 1]*3);
+    }
+    indices.swap(result);
+}
+
+void printOptimizationReport(const std::string &name, size_t vertexCountBefore, size_t vertexCountAfter,
+                             const VertexCacheStats &before, const VertexCacheStats &after)
+{
+    std::cout << "MESH_OPTIMIZER::" << name
+              << " vertices " << vertexCountBefore << " -> " << vertexCountAfter
+              << ", ACMR " << before.acmr << " -> " << after.acmr
+              << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+}
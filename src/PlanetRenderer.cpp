@@ -0,0 +1,310 @@
+#include <PlanetRenderer.hpp>
+#include <common.h>
+#include <KtxFile.hpp>
+#include <RenderState.hpp>
+#include <ResidencyManager.hpp>
+#include <TextureStreamer.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+GLenum PlanetRenderer::LayerFormatOf(const std::vector<std::string> &texturePaths)
+{
+    GLenum format = GL_RGBA8;
+    for(size_t i = 0; i < texturePaths.size(); ++i) {
+        // planet textures are loaded flipped
+        const GLenum baked = TextureArray::BakedFormatOf(KtxFile::BakedPath(texturePaths[i]), LayerWidth, LayerHeight,
+                                                         true);
+        if(baked == GL_RGBA8) {
+            std::cout << "WARNING::PLANET_RENDERER: " << texturePaths[i] << " has no KTX baked at " << LayerWidth
+                      << "x" << LayerHeight << " (make bake_textures), planet layers are RGBA8" << std::endl;
+            return GL_RGBA8;
+        }
+        if(i > 0 && baked != format) {
+            std::cout << "WARNING::PLANET_RENDERER: " << texturePaths[i] << " was baked in another format than "
+                      << texturePaths[0] << ", planet layers are RGBA8" << std::endl;
+            return GL_RGBA8;
+        }
+        format = baked;
+    }
+    return format;
+}
+
+PlanetRenderer::PlanetRenderer(const SphereLodChain &lods, StreamBuffer &stream, GLenum layerFormat)
+    : lods(lods),
+      stream(stream),
+      instanceOffset(0),
+      layers(LayerWidth, LayerHeight, 4, layerFormat),
+      mipmapsDirty(false),
+      trackedLayers(0),
+      drawCalls(0),
+      queuedShaders(nullptr)
+{
+    GL_ERROR_CHECK(glGenVertexArrays(1, &VAO));
+    setupBuffers();
+    trackLayers();
+
+    // a texture evicted while its layer was copied gets copied again once its finer levels are back,
+    // compressed layers are read from the files and never copied
+    promotionListener = ResidencyManager::Shared().AddPromotionListener([this](unsigned int texture) {
+        auto it = layerOfTexture.find(texture);
+        const int level = ResidencyManager::Shared().ResidentLevel(texture);
+        if(it != layerOfTexture.end() && level < layerLevel[it->second]) {
+            layers.Replace(it->second, texture);
+            layerLevel[it->second] = level;
+            mipmapsDirty = true;
+        }
+    });
+}
+
+PlanetRenderer::~PlanetRenderer()
+{
+    ResidencyManager::Shared().RemovePromotionListener(promotionListener);
+    ResidencyManager::Shared().Untrack(trackedLayers);
+    RenderState::ForgetVertexArray(VAO);
+    glDeleteVertexArrays(1, &VAO);
+}
+
+void PlanetRenderer::trackLayers()
+{
+    ResidencyManager &residency = ResidencyManager::Shared();
+    if(trackedLayers) {
+        residency.Untrack(trackedLayers);
+    }
+    trackedLayers = layers.Id();
+    // compressed layers are read from their KTX again, RGBA8 ones copied from their sources
+    residency.Track(trackedLayers, GL_TEXTURE_2D_ARRAY,
+                    [this](int first, int last) { return layers.LoadLevels(first, last); });
+}
+
+void PlanetRenderer::RequestLayer(int layer, float screenPixels)
+{
+    if(layer < 0) {
+        return;
+    }
+    ResidencyManager::Shared().Request(layers.Id(), screenPixels);
+    if(!layers.Compressed()) {
+        ResidencyManager::Shared().Request(layerSource[layer], screenPixels);
+    }
+}
+
+void PlanetRenderer::setupBuffers()
+{
+    GeometryArena &arena = SphereCache::Arena();
+    RenderState::BindVertexArray(VAO);
+
+    // Per-vertex attributes come straight from the sphere arena, every LOD lives in it
+    arena.SetupVertexAttributes();
+    arenaGeneration = arena.Generation();
+
+    // Per-instance attributes: model matrix (3-6), normal matrix (7-9), scale and layer (10),
+    // they are pointed at the frame's instances before each draw
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, stream.Id()));
+    bindInstanceAttributes(0);
+
+    for(unsigned int i=3;i<=10;++i) {
+        GL_ERROR_CHECK(glEnableVertexAttribArray(i));
+        GL_ERROR_CHECK(glVertexAttribDivisor(i, 1));
+    }
+
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+// GL 3.3 has no base instance, so a group that does not start at instance 0
+// is drawn by pointing the instance attributes at its first element.
+// Expects the VAO and stream buffer to be bound.
+void PlanetRenderer::bindInstanceAttributes(size_t firstInstance)
+{
+    const size_t base = instanceOffset + firstInstance * sizeof(PlanetInstance);
+
+    for(unsigned int i=0;i<4;++i) {
+        GL_ERROR_CHECK(glVertexAttribPointer(3+i, 4, GL_FLOAT, GL_FALSE, sizeof(PlanetInstance),
+                                             (void*)(base + offsetof(PlanetInstance, model) + i*sizeof(glm::vec4))));
+    }
+
+    for(unsigned int i=0;i<3;++i) {
+        GL_ERROR_CHECK(glVertexAttribPointer(7+i, 3, GL_FLOAT, GL_FALSE, sizeof(PlanetInstance),
+                                             (void*)(base + offsetof(PlanetInstance, normalMatrix) + i*sizeof(glm::vec3))));
+    }
+
+    GL_ERROR_CHECK(glVertexAttribPointer(10, 2, GL_FLOAT, GL_FALSE, sizeof(PlanetInstance),
+                                         (void*)(base + offsetof(PlanetInstance, scale))));
+}
+
+int PlanetRenderer::AddTexture(unsigned int textureId, const std::string &texturePath, bool translucent)
+{
+    if(textureId == 0) {
+        return -1;
+    }
+
+    auto it = layerOfTexture.find(textureId);
+    if(it != layerOfTexture.end()) {
+        return it->second;
+    }
+
+    if(layers.Compressed()) {
+        const std::string bakedPath = KtxFile::BakedPath(texturePath);
+        auto baked = layerOfBake.find(bakedPath);
+        if(baked != layerOfBake.end()) {
+            return baked->second;
+        }
+        const int layer = layers.AddBaked(bakedPath, true);
+        if(layer < 0) {
+            std::cout << "ERROR::PLANET_RENDERER: " << texturePath << " has no bake matching the layers, drawn untextured"
+                      << std::endl;
+            return -1;
+        }
+        // the baked levels are complete, nothing streams into the layer later
+        layerTranslucent.push_back(translucent);
+        layerLevel.push_back(0);
+        layerSource.push_back(0);
+        layerOfBake[bakedPath] = layer;
+        if(layers.Id() != trackedLayers) {
+            trackLayers();
+        }
+        return layer;
+    }
+
+    int layer = layers.Add(textureId);
+    if(layers.Id() != trackedLayers) {
+        trackLayers();
+    }
+    mipmapsDirty = true;
+    layerTranslucent.push_back(translucent);
+    layerLevel.push_back(ResidencyManager::Shared().ResidentLevel(textureId));
+    layerSource.push_back(textureId);
+    layerOfTexture[textureId] = layer;
+
+    // a streaming texture holds its placeholder until then, and only its image tells whether it has alpha
+    TextureStreamer::Shared().WhenReady(textureId, [this, layer](unsigned int texture, bool hasAlpha) {
+        layers.Replace(layer, texture);
+        layerTranslucent[layer] = hasAlpha;
+        layerLevel[layer] = ResidencyManager::Shared().ResidentLevel(texture);
+        mipmapsDirty = true;
+    });
+    return layer;
+}
+
+void PlanetRenderer::Begin()
+{
+    instances.clear();
+    drawCalls = 0;
+    std::fill(levelInstances, levelInstances + SphereLodChain::LevelCount, 0);
+}
+
+void PlanetRenderer::Submit(const glm::mat4 &model, const glm::mat3 &normalMatrix, float scale, int layer, int lod)
+{
+    PlanetInstance instance;
+    instance.model = model;
+    instance.normalMatrix[0] = normalMatrix[0];
+    instance.normalMatrix[1] = normalMatrix[1];
+    instance.normalMatrix[2] = normalMatrix[2];
+    instance.scale = scale;
+    instance.layer = layer;
+    instance.lod = lod;
+    instances.push_back(instance);
+    ++levelInstances[lod];
+}
+
+void PlanetRenderer::Queue(RenderQueue &queue, ShaderPermutations &shaders, const glm::vec3 &cameraPosition)
+{
+    if(instances.empty()) {
+        return;
+    }
+    queuedShaders = &shaders;
+
+    // The layers already pick the texture per instance, so only the shader variant,
+    // translucency and LOD split the instances into groups
+    std::stable_sort(instances.begin(), instances.end(), [this](const PlanetInstance &a, const PlanetInstance &b) {
+        const int groupA = groupOf(a), groupB = groupOf(b);
+        return groupA != groupB ? groupA < groupB : a.lod < b.lod;
+    });
+
+    if(mipmapsDirty) {
+        layers.GenerateMipmaps();
+        mipmapsDirty = false;
+    }
+
+    const StreamAllocation allocation = stream.Allocate(sizeof(PlanetInstance) * instances.size());
+    if(!allocation.pointer) {
+        return;
+    }
+    std::memcpy(allocation.pointer, &instances[0], sizeof(PlanetInstance) * instances.size());
+    instanceOffset = allocation.offset;
+
+    // The arena replaced its buffers since the VAO was built
+    if(arenaGeneration != SphereCache::Arena().Generation()) {
+        setupBuffers();
+    }
+
+    size_t first = 0;
+    while(first < instances.size()) {
+        const int lod = instances[first].lod;
+        const int group = groupOf(instances[first]);
+        size_t last = first;
+        while(last < instances.size() && instances[last].lod == lod && groupOf(instances[last]) == group) {
+            ++last;
+        }
+
+        const unsigned int program = shaders.Get(group != UntexturedGroup ? FeatureTexture : 0u).ID;
+        const unsigned int material = group != UntexturedGroup ? layers.Id() : 0;
+
+        if(group == TranslucentGroup) {
+            // blended bodies have to be drawn back to front, one packet each
+            for(size_t i = first; i < last; ++i) {
+                queue.Submit(queue.Key(TransparentPass, BlendAlpha, program, material, depthOf(instances[i], cameraPosition)),
+                             &PlanetRenderer::drawPacket, this, i, 1);
+            }
+        }
+        else {
+            // the nearest body of the group decides, that is where most of the early-Z rejection comes from
+            float depth = depthOf(instances[first], cameraPosition);
+            for(size_t i = first + 1; i < last; ++i) {
+                depth = std::min(depth, depthOf(instances[i], cameraPosition));
+            }
+            queue.Submit(queue.Key(OpaquePass, BlendNone, program, material, depth),
+                         &PlanetRenderer::drawPacket, this, first, last - first);
+        }
+
+        first = last;
+    }
+}
+
+int PlanetRenderer::groupOf(const PlanetInstance &instance) const
+{
+    const int layer = (int)instance.layer;
+    if(layer < 0) {
+        return UntexturedGroup;
+    }
+    return layerTranslucent[layer] ? TranslucentGroup : TexturedGroup;
+}
+
+float PlanetRenderer::depthOf(const PlanetInstance &instance, const glm::vec3 &cameraPosition)
+{
+    // the shader scales the whole model matrix, translation included
+    return glm::length(instance.scale * glm::vec3(instance.model[3]) - cameraPosition);
+}
+
+void PlanetRenderer::drawPacket(void *object, unsigned int first, unsigned int count)
+{
+    PlanetRenderer &renderer = *(PlanetRenderer*)object;
+    const PlanetInstance &instance = renderer.instances[first];
+    const int layer = (int)instance.layer;
+
+    renderer.queuedShaders->Get(layer >= 0 ? FeatureTexture : 0u).use();
+    if(layer >= 0) {
+        RenderState::BindTexture(0, GL_TEXTURE_2D_ARRAY, renderer.layers.Id());
+    }
+    RenderState::SetCullFace(true, GL_BACK);
+    RenderState::BindVertexArray(renderer.VAO);
+
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, renderer.stream.Id()));
+    renderer.bindInstanceAttributes(first);
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+    const GeometryRange &range = renderer.lods.Level(instance.lod)->range;
+    GL_ERROR_CHECK(glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, range.indexType,
+                                                     (void*)range.indexOffset, count, range.baseVertex));
+    ++renderer.drawCalls;
+}
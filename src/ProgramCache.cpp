@@ -0,0 +1,165 @@
+#include <ProgramCache.hpp>
+#include <GLExtensions.hpp>
+#include <common.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+std::string ProgramCache::Directory = "shader_cache";
+bool ProgramCache::Enabled = true;
+unsigned int ProgramCache::hits = 0;
+unsigned int ProgramCache::misses = 0;
+
+namespace {
+    // File layout: magic, binary format, binary length, binary
+    const uint32_t CacheMagic = 0x31424750; // "PGB1"
+
+    std::string driverString()
+    {
+        std::string driver;
+        for(GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+            const char *value = (const char*)glGetString(name);
+            driver += value ? value : "";
+            driver += '\n';
+        }
+        return driver;
+    }
+}
+
+std::string ProgramCache::Key(const std::vector<std::string> &sources)
+{
+    static const std::string driver = driverString();
+
+    size_t hash = hashBytes(driver.data(), driver.size());
+    for(const std::string &source : sources) {
+        // the length keeps "ab" + "c" apart from "a" + "bc"
+        const uint64_t length = source.size();
+        hash = hashBytes(&length, sizeof(length), hash);
+        hash = hashBytes(source.data(), source.size(), hash);
+    }
+
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+    return key;
+}
+
+std::string ProgramCache::path(const std::string &key)
+{
+    return Directory + "/" + key + ".bin";
+}
+
+bool ProgramCache::Load(unsigned int program, const std::string &key)
+{
+    if(!Enabled || !GLExtensions::HasProgramBinary) {
+        return false;
+    }
+
+    std::ifstream in(path(key), std::ios::binary);
+    uint32_t magic = 0, format = 0, length = 0;
+    if(!in.read((char*)&magic, sizeof(magic)) || magic != CacheMagic
+       || !in.read((char*)&format, sizeof(format)) || !in.read((char*)&length, sizeof(length))) {
+        ++misses;
+        return false;
+    }
+
+    std::vector<char> binary(length);
+    if(!in.read(binary.data(), length)) {
+        ++misses;
+        return false;
+    }
+
+    // the driver may reject binaries of an older build, the caller then compiles from source
+    GLExtensions::ProgramBinary(program, format, binary.data(), length);
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if(linked != GL_TRUE) {
+        ++misses;
+        return false;
+    }
+
+    // the modification time is the last use, prune goes by it
+    utime(path(key).c_str(), nullptr);
+    ++hits;
+    return true;
+}
+
+void ProgramCache::Remove(const std::string &key)
+{
+    if(Enabled && !key.empty()) {
+        std::remove(path(key).c_str());
+    }
+}
+
+void ProgramCache::prune()
+{
+    DIR *directory = opendir(Directory.c_str());
+    if(!directory) {
+        return;
+    }
+
+    struct Entry
+    {
+        std::string path;
+        time_t lastUsed;
+        size_t bytes;
+    };
+    std::vector<Entry> entries;
+    size_t totalBytes = 0;
+    while(dirent *file = readdir(directory)) {
+        const std::string name = file->d_name;
+        struct stat info;
+        if(name.size() < 4 || name.compare(name.size() - 4, 4, ".bin") != 0
+           || stat((Directory + "/" + name).c_str(), &info) != 0) {
+            continue;
+        }
+        entries.push_back(Entry{Directory + "/" + name, info.st_mtime, (size_t)info.st_size});
+        totalBytes += info.st_size;
+    }
+    closedir(directory);
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.lastUsed < b.lastUsed; });
+    for(size_t i = 0; i < entries.size() && totalBytes > MaxBytes; ++i) {
+        if(std::remove(entries[i].path.c_str()) == 0) {
+            totalBytes -= entries[i].bytes;
+        }
+    }
+}
+
+void ProgramCache::MarkRetrievable(unsigned int program)
+{
+    if(Enabled && GLExtensions::HasProgramBinary) {
+        GLExtensions::ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void ProgramCache::Store(unsigned int program, const std::string &key)
+{
+    if(!Enabled || !GLExtensions::HasProgramBinary) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0) {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    GLExtensions::GetProgramBinary(program, length, &written, &format, binary.data());
+
+    mkdir(Directory.c_str(), 0755);
+    std::ofstream out(path(key), std::ios::binary | std::ios::trunc);
+    const uint32_t header[3] = {CacheMagic, (uint32_t)format, (uint32_t)written};
+    out.write((const char*)header, sizeof(header));
+    out.write(binary.data(), written);
+    if(!out) {
+        std::cout << "ProgramCache: could not write " << path(key) << std::endl;
+    }
+    out.close();
+    prune();
+}
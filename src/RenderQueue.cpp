@@ -0,0 +1,118 @@
+#include <RenderQueue.hpp>
+#include <RenderState.hpp>
+
+#include <algorithm>
+
+namespace {
+    const unsigned int DepthBits = 24, MaterialBits = 24, ProgramBits = 12, BlendBits = 2;
+
+    uint64_t field(uint64_t value, unsigned int bits)
+    {
+        return value & ((1ull << bits) - 1);
+    }
+}
+
+void RenderQueue::Begin(float farDistance)
+{
+    this->farDistance = farDistance;
+    packets.clear();
+    entries.clear();
+    std::fill(passPackets, passPackets + RenderPassCount, 0);
+}
+
+uint64_t RenderQueue::MakeKey(RenderPass pass, BlendMode blend, unsigned int program, unsigned int material,
+                              float depth, float farDistance)
+{
+    const float normalized = std::min(std::max(depth / farDistance, 0.0f), 1.0f);
+    const uint64_t quantized = (uint64_t)(normalized * ((1u << DepthBits) - 1));
+
+    uint64_t key = (uint64_t)pass << 62;
+    if(pass == TransparentPass) {
+        key |= field(~quantized, DepthBits) << (64 - 2 - DepthBits);
+        key |= field(blend, BlendBits) << (MaterialBits + ProgramBits);
+        key |= field(program, ProgramBits) << MaterialBits;
+        key |= field(material, MaterialBits);
+    }
+    else {
+        key |= field(blend, BlendBits) << (DepthBits + MaterialBits + ProgramBits);
+        key |= field(program, ProgramBits) << (DepthBits + MaterialBits);
+        key |= field(material, MaterialBits) << DepthBits;
+        key |= field(quantized, DepthBits);
+    }
+    return key;
+}
+
+void RenderQueue::Submit(uint64_t key, DrawFunction draw, void *object, unsigned int first, unsigned int count)
+{
+    entries.push_back(SortEntry{key, (uint32_t)packets.size()});
+    packets.push_back(DrawPacket{draw, object, first, count});
+    ++passPackets[key >> 62];
+}
+
+// LSD radix sort on the key bytes, stable, bytes every key shares are skipped
+void RenderQueue::sort()
+{
+    scratch.resize(entries.size());
+    for(unsigned int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {};
+        for(const SortEntry &entry : entries) {
+            ++counts[(entry.key >> shift) & 0xFF];
+        }
+        if(counts[(entries[0].key >> shift) & 0xFF] == entries.size()) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for(size_t &count : counts) {
+            const size_t bucket = count;
+            count = offset;
+            offset += bucket;
+        }
+        for(const SortEntry &entry : entries) {
+            scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
+
+void RenderQueue::setPassState(RenderPass pass)
+{
+    switch(pass) {
+    case BackgroundPass:
+        RenderState::SetBlend(false);
+        RenderState::SetDepthMask(false);
+        break;
+    case OpaquePass:
+        RenderState::SetBlend(false);
+        RenderState::SetDepthMask(true);
+        break;
+    default:
+        // transparent surfaces are depth tested against the opaque ones but do not occlude each other
+        RenderState::SetBlend(true);
+        RenderState::SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        RenderState::SetDepthMask(false);
+        break;
+    }
+}
+
+void RenderQueue::Execute()
+{
+    if(entries.empty()) {
+        return;
+    }
+    sort();
+
+    int pass = -1;
+    for(const SortEntry &entry : entries) {
+        const int entryPass = (int)(entry.key >> 62);
+        if(entryPass != pass) {
+            pass = entryPass;
+            setPassState((RenderPass)pass);
+        }
+        const DrawPacket &packet = packets[entry.packet];
+        packet.draw(packet.object, packet.first, packet.count);
+    }
+
+    // leave the defaults the rest of the frame expects
+    RenderState::SetDepthMask(true);
+}
@@ -0,0 +1,227 @@
+#include <RenderState.hpp>
+
+unsigned int RenderState::program;
+unsigned int RenderState::vertexArray;
+unsigned int RenderState::activeUnit;
+unsigned int RenderState::textures[RenderState::MaxTextureUnits][RenderState::TextureTargetCount];
+unsigned int RenderState::uniformBuffers[RenderState::MaxUniformBindings];
+size_t RenderState::uniformOffsets[RenderState::MaxUniformBindings];
+size_t RenderState::uniformSizes[RenderState::MaxUniformBindings];
+int RenderState::blend, RenderState::cullFace, RenderState::depthTest, RenderState::depthMask;
+int RenderState::viewport[4];
+GLenum RenderState::blendSource, RenderState::blendDestination, RenderState::cullMode;
+unsigned int RenderState::issued, RenderState::skipped;
+
+void RenderState::Invalidate()
+{
+    program = Unknown;
+    vertexArray = Unknown;
+    activeUnit = Unknown;
+    for(unsigned int unit=0;unit<MaxTextureUnits;++unit) {
+        for(int target=0;target<TextureTargetCount;++target) {
+            textures[unit][target] = Unknown;
+        }
+    }
+    for(unsigned int binding=0;binding<MaxUniformBindings;++binding) {
+        uniformBuffers[binding] = Unknown;
+        uniformOffsets[binding] = uniformSizes[binding] = 0;
+    }
+
+    blend = cullFace = depthTest = depthMask = -1;
+    viewport[0] = viewport[1] = viewport[2] = viewport[3] = -1;
+    blendSource = blendDestination = cullMode = Unknown;
+}
+
+void RenderState::BeginFrame()
+{
+    issued = 0;
+    skipped = 0;
+}
+
+bool RenderState::changed(bool differs)
+{
+    if(differs) {
+        ++issued;
+    }
+    else {
+        ++skipped;
+    }
+    return differs;
+}
+
+int RenderState::targetIndex(GLenum target)
+{
+    switch(target) {
+    case GL_TEXTURE_CUBE_MAP:
+        return TextureCubeMap;
+    case GL_TEXTURE_2D_ARRAY:
+        return Texture2DArray;
+    default:
+        return Texture2D;
+    }
+}
+
+void RenderState::UseProgram(unsigned int id)
+{
+    if(changed(program != id)) {
+        glUseProgram(id);
+        program = id;
+    }
+}
+
+void RenderState::BindVertexArray(unsigned int vao)
+{
+    if(changed(vertexArray != vao)) {
+        glBindVertexArray(vao);
+        vertexArray = vao;
+    }
+}
+
+void RenderState::BindTexture(unsigned int unit, GLenum target, unsigned int texture)
+{
+    unsigned int &bound = textures[unit][targetIndex(target)];
+    if(!changed(bound != texture)) {
+        return;
+    }
+
+    if(changed(activeUnit != unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+
+    glBindTexture(target, texture);
+    bound = texture;
+}
+
+void RenderState::setCapability(GLenum capability, int &shadow, bool enabled)
+{
+    if(changed(shadow != (int)enabled)) {
+        if(enabled) {
+            glEnable(capability);
+        }
+        else {
+            glDisable(capability);
+        }
+        shadow = enabled;
+    }
+}
+
+void RenderState::SetBlend(bool enabled)
+{
+    setCapability(GL_BLEND, blend, enabled);
+}
+
+void RenderState::SetBlendFunc(GLenum source, GLenum destination)
+{
+    if(changed(blendSource != source || blendDestination != destination)) {
+        glBlendFunc(source, destination);
+        blendSource = source;
+        blendDestination = destination;
+    }
+}
+
+void RenderState::SetCullFace(bool enabled, GLenum mode)
+{
+    setCapability(GL_CULL_FACE, cullFace, enabled);
+
+    if(enabled && changed(cullMode != mode)) {
+        glCullFace(mode);
+        cullMode = mode;
+    }
+}
+
+void RenderState::SetDepthTest(bool enabled)
+{
+    setCapability(GL_DEPTH_TEST, depthTest, enabled);
+}
+
+void RenderState::SetDepthMask(bool enabled)
+{
+    if(changed(depthMask != (int)enabled)) {
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+        depthMask = enabled;
+    }
+}
+
+void RenderState::SetViewport(int x, int y, int width, int height)
+{
+    if(changed(viewport[0] != x || viewport[1] != y || viewport[2] != width || viewport[3] != height)) {
+        glViewport(x, y, width, height);
+        viewport[0] = x;
+        viewport[1] = y;
+        viewport[2] = width;
+        viewport[3] = height;
+    }
+}
+
+RenderState::Saved RenderState::Save()
+{
+    return Saved{blend, cullFace, depthTest, {viewport[0], viewport[1], viewport[2], viewport[3]}};
+}
+
+void RenderState::Restore(const Saved &saved)
+{
+    int *shadows[] = {&blend, &cullFace, &depthTest};
+    const GLenum capabilities[] = {GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST};
+    const int values[] = {saved.blend, saved.cullFace, saved.depthTest};
+    for(int i=0;i<3;++i) {
+        if(values[i] < 0) {
+            *shadows[i] = -1;
+        }
+        else {
+            setCapability(capabilities[i], *shadows[i], values[i] != 0);
+        }
+    }
+
+    if(saved.viewport[2] < 0) {
+        viewport[0] = viewport[1] = viewport[2] = viewport[3] = -1;
+    }
+    else {
+        SetViewport(saved.viewport[0], saved.viewport[1], saved.viewport[2], saved.viewport[3]);
+    }
+}
+
+void RenderState::BindUniformBuffer(unsigned int binding, unsigned int buffer)
+{
+    if(changed(uniformBuffers[binding] != buffer || uniformSizes[binding] != 0)) {
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+        uniformBuffers[binding] = buffer;
+        uniformOffsets[binding] = uniformSizes[binding] = 0;
+    }
+}
+
+void RenderState::BindUniformBufferRange(unsigned int binding, unsigned int buffer, size_t offset, size_t size)
+{
+    if(changed(uniformBuffers[binding] != buffer || uniformOffsets[binding] != offset
+               || uniformSizes[binding] != size)) {
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+        uniformBuffers[binding] = buffer;
+        uniformOffsets[binding] = offset;
+        uniformSizes[binding] = size;
+    }
+}
+
+void RenderState::ForgetProgram(unsigned int id)
+{
+    if(program == id) {
+        program = Unknown;
+    }
+}
+
+void RenderState::ForgetVertexArray(unsigned int vao)
+{
+    if(vertexArray == vao) {
+        vertexArray = Unknown;
+    }
+}
+
+void RenderState::ForgetTexture(unsigned int texture)
+{
+    for(unsigned int unit=0;unit<MaxTextureUnits;++unit) {
+        for(int target=0;target<TextureTargetCount;++target) {
+            if(textures[unit][target] == texture) {
+                textures[unit][target] = Unknown;
+            }
+        }
+    }
+}
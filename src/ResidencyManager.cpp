@@ -0,0 +1,339 @@
+#include <ResidencyManager.hpp>
+#include <GLExtensions.hpp>
+#include <KtxFile.hpp>
+#include <RenderState.hpp>
+#include <TextureStreamer.hpp>
+#include <common.h>
+
+#include <algorithm>
+#include <iostream>
+
+ResidencyManager& ResidencyManager::Shared()
+{
+    static ResidencyManager *manager = new ResidencyManager();
+    return *manager;
+}
+
+void ResidencyManager::Track(unsigned int texture, GLenum target, const std::vector<std::string> &sources,
+                             const std::string &bakedPath, bool flipVertically)
+{
+    Entry entry;
+    entry.target = target;
+    entry.sources = sources;
+    entry.bakedPath = bakedPath;
+    entry.flipVertically = flipVertically;
+    entries[texture] = entry;
+}
+
+void ResidencyManager::Track(unsigned int texture, GLenum target, TextureLevelLoader load)
+{
+    Entry entry;
+    entry.target = target;
+    entry.flipVertically = false;
+    entry.load = std::move(load);
+    entries[texture] = entry;
+}
+
+void ResidencyManager::Untrack(unsigned int texture)
+{
+    entries.erase(texture);
+}
+
+void ResidencyManager::Request(unsigned int texture, float screenPixels)
+{
+    auto it = entries.find(texture);
+    if(it == entries.end()) {
+        return;
+    }
+    Entry &entry = it->second;
+    entry.screenPixels = entry.lastRequested == frame ? std::max(entry.screenPixels, screenPixels) : screenPixels;
+    entry.lastRequested = frame;
+}
+
+int ResidencyManager::ResidentLevel(unsigned int texture) const
+{
+    auto it = entries.find(texture);
+    return it != entries.end() ? it->second.resident : 0;
+}
+
+unsigned int ResidencyManager::AddPromotionListener(TexturePromoted listener)
+{
+    listeners[nextListener] = std::move(listener);
+    return nextListener++;
+}
+
+void ResidencyManager::RemovePromotionListener(unsigned int id)
+{
+    listeners.erase(id);
+}
+
+void ResidencyManager::learn(unsigned int texture, Entry &entry)
+{
+    const GLenum levelTarget = entry.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : entry.target;
+    GLint width = 0, height = 0, depth = 1, internalFormat = 0, compressed = GL_FALSE, baseLevel = 0, maxLevel = 0;
+    RenderState::BindTexture(0, entry.target, texture);
+    GL_ERROR_CHECK(glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_WIDTH, &width));
+    GL_ERROR_CHECK(glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_HEIGHT, &height));
+    if(entry.target == GL_TEXTURE_2D_ARRAY) {
+        GL_ERROR_CHECK(glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_DEPTH, &depth));
+    }
+    GL_ERROR_CHECK(glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat));
+    GL_ERROR_CHECK(glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_COMPRESSED, &compressed));
+    GL_ERROR_CHECK(glGetTexParameteriv(entry.target, GL_TEXTURE_BASE_LEVEL, &baseLevel));
+    GL_ERROR_CHECK(glGetTexParameteriv(entry.target, GL_TEXTURE_MAX_LEVEL, &maxLevel));
+
+    entry.known = true;
+    entry.width = width;
+    entry.height = height;
+    entry.internalFormat = internalFormat;
+    entry.compressed = compressed != GL_FALSE;
+    entry.faces = entry.target == GL_TEXTURE_CUBE_MAP ? 6 : std::max(depth, 1);
+    entry.levels = 0;
+    while(entry.levels <= maxLevel && (std::max(width, height) >> entry.levels) > 0) {
+        ++entry.levels;
+    }
+
+    // a texture whose stream failed still shows its placeholder from the smallest level
+    entry.managed = width > 0 && height > 0 && baseLevel == 0
+                    && (entry.load || (entry.compressed ? !entry.bakedPath.empty() : !entry.sources.empty()));
+}
+
+size_t ResidencyManager::levelBytes(const Entry &entry, int level)
+{
+    const size_t width = std::max(entry.width >> level, 1), height = std::max(entry.height >> level, 1);
+    if(entry.compressed) {
+        const size_t blockBytes = entry.internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16;
+        return ((width + 3) / 4) * ((height + 3) / 4) * blockBytes * entry.faces;
+    }
+    // drivers pad RGB8 to four bytes a texel
+    switch(entry.internalFormat) {
+        case GL_R8: return width * height * entry.faces;
+        case GL_RG8: return width * height * 2 * entry.faces;
+        default: return width * height * 4 * entry.faces;
+    }
+}
+
+size_t ResidencyManager::levelRangeBytes(const Entry &entry, int first, int last)
+{
+    size_t bytes = 0;
+    for(int level = first; level < last; ++level) {
+        bytes += levelBytes(entry, level);
+    }
+    return bytes;
+}
+
+int ResidencyManager::wantedLevel(const Entry &entry)
+{
+    int level = 0;
+    while(level + 1 < entry.levels && (entry.width >> (level + 1)) >= entry.screenPixels) {
+        ++level;
+    }
+    return level;
+}
+
+int ResidencyManager::evictLevel(const Entry &entry)
+{
+    int level = 0;
+    while(level + 1 < entry.levels && (std::max(entry.width, entry.height) >> level) > EvictSize) {
+        ++level;
+    }
+    return level;
+}
+
+void ResidencyManager::demote(unsigned int texture, Entry &entry, int level)
+{
+    RenderState::BindTexture(0, entry.target, texture);
+    GL_ERROR_CHECK(glTexParameteri(entry.target, GL_TEXTURE_BASE_LEVEL, level));
+    // outside base..max the levels do not count for completeness, empty ones hold no memory
+    for(int dropped = entry.resident; dropped < level; ++dropped) {
+        // the layers of an array are one image per level
+        if(entry.target == GL_TEXTURE_2D_ARRAY) {
+            if(entry.compressed) {
+                GL_ERROR_CHECK(glCompressedTexImage3D(entry.target, dropped, entry.internalFormat, 0, 0, 0, 0, 0, nullptr));
+            }
+            else {
+                GL_ERROR_CHECK(glTexImage3D(entry.target, dropped, entry.internalFormat, 0, 0, 0, 0, GL_RGBA,
+                                            GL_UNSIGNED_BYTE, nullptr));
+            }
+            continue;
+        }
+        for(unsigned int face = 0; face < entry.faces; ++face) {
+            const GLenum faceTarget = entry.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face
+                                                                          : entry.target;
+            if(entry.compressed) {
+                GL_ERROR_CHECK(glCompressedTexImage2D(faceTarget, dropped, entry.internalFormat, 0, 0, 0, 0, nullptr));
+            }
+            else {
+                GL_ERROR_CHECK(glTexImage2D(faceTarget, dropped, entry.internalFormat, 0, 0, 0, GL_RGBA,
+                                            GL_UNSIGNED_BYTE, nullptr));
+            }
+        }
+    }
+    entry.resident = level;
+}
+
+bool ResidencyManager::promote(unsigned int texture, Entry &entry, int level)
+{
+    // the owner reads or draws them back itself, synchronously like a KTX
+    if(entry.load) {
+        if(!entry.load(level, entry.resident)) {
+            std::cout << "ERROR::RESIDENCY_MANAGER: texture " << texture << " could not load its dropped levels"
+                      << std::endl;
+            entry.managed = false;
+            return false;
+        }
+        RenderState::BindTexture(0, entry.target, texture);
+        GL_ERROR_CHECK(glTexParameteri(entry.target, GL_TEXTURE_BASE_LEVEL, level));
+        promoted(texture, level);
+        return true;
+    }
+
+    if(!entry.compressed) {
+        // the image is decoded again, scaled down to level on the worker, and streamed in
+        if(!TextureStreamer::Shared().Reload(texture, entry.target, entry.sources, entry.flipVertically, level,
+                                             [this, level](unsigned int texture, bool) { promoted(texture, level); })) {
+            return false;
+        }
+        entry.promotingTo = level;
+        return true;
+    }
+
+    // the levels are ready to upload as they are, small enough to read on the GL thread
+    KtxFile ktx;
+    if(!ktx.Read(entry.bakedPath) || ktx.internalFormat != entry.internalFormat || ktx.faces != entry.faces
+       || (int)ktx.width != entry.width || (int)ktx.height != entry.height || (int)ktx.Levels() < entry.resident
+       || ktx.orientation != (entry.flipVertically ? KtxFile::OrientationUp : KtxFile::OrientationDown)) {
+        std::cout << "ERROR::RESIDENCY_MANAGER: " << entry.bakedPath << " no longer matches texture " << texture
+                  << ", keeping its levels" << std::endl;
+        entry.managed = false;
+        return false;
+    }
+    RenderState::BindTexture(0, entry.target, texture);
+    for(int loaded = level; loaded < entry.resident; ++loaded) {
+        for(unsigned int face = 0; face < entry.faces; ++face) {
+            const GLenum faceTarget = entry.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face
+                                                                          : entry.target;
+            const std::vector<unsigned char> &data = ktx.data[loaded][face];
+            GL_ERROR_CHECK(glCompressedTexImage2D(faceTarget, loaded, entry.internalFormat, ktx.LevelWidth(loaded),
+                                                  ktx.LevelHeight(loaded), 0, data.size(), &data[0]));
+        }
+    }
+    GL_ERROR_CHECK(glTexParameteri(entry.target, GL_TEXTURE_BASE_LEVEL, level));
+    promoted(texture, level);
+    return true;
+}
+
+void ResidencyManager::promoted(unsigned int texture, int level)
+{
+    auto it = entries.find(texture);
+    if(it == entries.end()) {
+        return;
+    }
+    it->second.resident = std::min(it->second.resident, level);
+    it->second.promotingTo = -1;
+    ++promotions;
+    for(auto &listener : listeners) {
+        listener.second(texture);
+    }
+}
+
+void ResidencyManager::Update()
+{
+    TextureStreamer &streamer = TextureStreamer::Shared();
+    residentBytes = 0;
+    promoting = 0;
+    // levels being streamed in, they take memory before they count as resident
+    size_t promisedBytes = 0;
+
+    // requested textures by the frame they were last requested in
+    std::vector<std::pair<unsigned long, unsigned int>> order;
+    for(auto &item : entries) {
+        Entry &entry = item.second;
+        if(streamer.IsPending(item.first)) {
+            if(entry.promotingTo >= 0) {
+                ++promoting;
+                promisedBytes += levelRangeBytes(entry, entry.promotingTo, entry.resident);
+                residentBytes += levelRangeBytes(entry, entry.resident, entry.levels);
+            }
+            continue;
+        }
+        // a promotion that ended without its ready callback failed, the texture keeps its levels
+        if(entry.promotingTo >= 0) {
+            entry.promotingTo = -1;
+            entry.managed = false;
+        }
+        if(!entry.known) {
+            learn(item.first, entry);
+        }
+        residentBytes += levelRangeBytes(entry, entry.resident, entry.levels);
+        if(entry.managed && entry.lastRequested) {
+            order.push_back(std::make_pair(entry.lastRequested, item.first));
+        }
+    }
+    std::sort(order.begin(), order.end());
+
+    // over budget, least recently requested first: seen ones down to the level they need, unseen ones to EvictSize
+    for(size_t i = 0; i < order.size() && residentBytes + promisedBytes > budget; ++i) {
+        Entry &entry = entries[order[i].second];
+        const int level = entry.lastRequested == frame ? wantedLevel(entry) : evictLevel(entry);
+        if(level > entry.resident) {
+            residentBytes -= levelRangeBytes(entry, entry.resident, level);
+            demote(order[i].second, entry, level);
+            ++evictions;
+        }
+    }
+
+    // textures seen last frame that need finer levels, the ones missing the most first
+    std::vector<std::pair<int, unsigned int>> wanted;
+    for(const auto &requested : order) {
+        Entry &entry = entries[requested.second];
+        const int level = wantedLevel(entry);
+        if(entry.lastRequested == frame && level < entry.resident) {
+            wanted.push_back(std::make_pair(level - entry.resident, requested.second));
+        }
+    }
+    std::sort(wanted.begin(), wanted.end());
+
+    unsigned int started = 0;
+    for(size_t w = 0; w < wanted.size() && started < PromotionsPerFrame; ++w) {
+        Entry &entry = entries[wanted[w].second];
+        int level = entry.resident + wanted[w].first;
+
+        // make room from the textures not seen last frame, least recently seen first
+        for(size_t i = 0; i < order.size() && residentBytes + promisedBytes
+                                                  + levelRangeBytes(entry, level, entry.resident) > budget; ++i) {
+            Entry &unseen = entries[order[i].second];
+            if(unseen.lastRequested == frame) {
+                break;
+            }
+            const int evict = evictLevel(unseen);
+            if(evict > unseen.resident) {
+                residentBytes -= levelRangeBytes(unseen, unseen.resident, evict);
+                demote(order[i].second, unseen, evict);
+                ++evictions;
+            }
+        }
+        // and settle for the finest level that fits
+        while(level < entry.resident
+              && residentBytes + promisedBytes + levelRangeBytes(entry, level, entry.resident) > budget) {
+            ++level;
+        }
+        if(level == entry.resident) {
+            continue;
+        }
+
+        const size_t bytes = levelRangeBytes(entry, level, entry.resident);
+        if(promote(wanted[w].second, entry, level)) {
+            ++started;
+            if(entry.promotingTo >= 0) {
+                ++promoting;
+                promisedBytes += bytes;
+            }
+            else {
+                residentBytes += bytes;
+            }
+        }
+    }
+
+    ++frame;
+}
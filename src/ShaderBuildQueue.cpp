@@ -0,0 +1,47 @@
+#include <ShaderBuildQueue.hpp>
+
+#include <future>
+
+Shader& ShaderBuildQueue::Add(const std::string &vertexPath, const std::string &fragmentPath,
+                              const std::vector<std::string> &defines)
+{
+    std::future<ShaderSources> sources = std::async(std::launch::async, [vertexPath, fragmentPath, defines]() {
+        return Shader::ReadSources(vertexPath, fragmentPath, "", defines);
+    });
+
+    shaders.emplace_back(new Shader(vertexPath, fragmentPath, std::move(sources), defines));
+    return *shaders.back();
+}
+
+void ShaderBuildQueue::Submit()
+{
+    for(; submitted < shaders.size(); ++submitted) {
+        shaders[submitted]->StartBuild();
+    }
+}
+
+unsigned int ShaderBuildQueue::Poll()
+{
+    unsigned int compiling = 0;
+    for(size_t i = 0; i < submitted; ++i) {
+        Shader &shader = *shaders[i];
+        if(shader.IsReady()) {
+            continue;
+        }
+        if(shader.IsBuildComplete()) {
+            shader.FinishBuild();
+        }
+        else {
+            ++compiling;
+        }
+    }
+    return compiling;
+}
+
+void ShaderBuildQueue::Finish()
+{
+    Submit();
+    for(std::unique_ptr<Shader> &shader : shaders) {
+        shader->FinishBuild();
+    }
+}
@@ -0,0 +1,80 @@
+#include <ShaderHotReload.hpp>
+#include <learnopengl/shader.h>
+
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::string fileName(const std::string &path)
+    {
+        const std::string::size_type slash = path.find_last_of('/');
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+}
+
+ShaderHotReload::ShaderHotReload(const std::string &directory)
+    : directory(directory),
+      inotifyDescriptor(-1),
+      watchDescriptor(-1),
+      reloads(0)
+{
+#ifdef __linux__
+    inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotifyDescriptor >= 0) {
+        // editors either write in place or write a new file and rename it over the old one
+        watchDescriptor = inotify_add_watch(inotifyDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    }
+#endif
+    if(watchDescriptor < 0) {
+        std::cout << "ShaderHotReload: can not watch " << directory << ", shaders will not reload" << std::endl;
+    }
+}
+
+ShaderHotReload::~ShaderHotReload()
+{
+#ifdef __linux__
+    if(inotifyDescriptor >= 0) {
+        close(inotifyDescriptor);
+    }
+#endif
+}
+
+void ShaderHotReload::Update()
+{
+#ifdef __linux__
+    if(watchDescriptor >= 0) {
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while((length = read(inotifyDescriptor, buffer, sizeof(buffer))) > 0) {
+            for(char *event = buffer; event < buffer + length; ) {
+                const inotify_event *change = (const inotify_event*)event;
+                if(change->len > 0) {
+                    fileChanged(change->name);
+                }
+                event += sizeof(inotify_event) + change->len;
+            }
+        }
+    }
+#endif
+
+    for(Shader *shader : Shader::Instances()) {
+        if(shader->PollReload()) {
+            ++reloads;
+            std::cout << "ShaderHotReload: reloaded " << shader->vPath << " + " << shader->fPath << std::endl;
+        }
+    }
+}
+
+void ShaderHotReload::fileChanged(const std::string &name)
+{
+    for(Shader *shader : Shader::Instances()) {
+        if(fileName(shader->vPath) == name || fileName(shader->fPath) == name
+           || (!shader->gPath.empty() && fileName(shader->gPath) == name)) {
+            shader->Reload();
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#include <ShaderPermutations.hpp>
+
+const std::vector<std::string>& ShaderFeatureDefines()
+{
+    static const std::vector<std::string> defines {
+        "HAS_TEXTURE"
+    };
+    return defines;
+}
+
+ShaderPermutations::ShaderPermutations(const std::string &vertexPath, const std::string &fragmentPath)
+    : vertexPath(vertexPath),
+      fragmentPath(fragmentPath)
+{
+}
+
+void ShaderPermutations::SetInitializer(std::function<void(Shader&)> initializer)
+{
+    this->initializer = initializer;
+    for(auto &variant : variants) {
+        variant.second->SetLinkCallback(initializer);
+    }
+}
+
+std::vector<std::string> ShaderPermutations::definesOf(unsigned int features)
+{
+    std::vector<std::string> defines;
+    const std::vector<std::string> &featureDefines = ShaderFeatureDefines();
+    for(unsigned int bit = 0; bit < featureDefines.size(); ++bit) {
+        if(features & (1u << bit)) {
+            defines.push_back(featureDefines[bit]);
+        }
+    }
+    return defines;
+}
+
+void ShaderPermutations::Prefetch(unsigned int features, ShaderBuildQueue &queue)
+{
+    if(variants.count(features) == 0) {
+        Shader &shader = queue.Add(vertexPath, fragmentPath, definesOf(features));
+        shader.SetLinkCallback(initializer);
+        variants[features] = &shader;
+    }
+}
+
+Shader& ShaderPermutations::Get(unsigned int features)
+{
+    auto it = variants.find(features);
+    if(it != variants.end()) {
+        return *it->second;
+    }
+
+    owned.emplace_back(new Shader(vertexPath.c_str(), fragmentPath.c_str(), nullptr, definesOf(features)));
+    Shader &shader = *owned.back();
+    shader.SetLinkCallback(initializer);
+    variants[features] = &shader;
+    return shader;
+}
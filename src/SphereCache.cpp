@@ -0,0 +1,140 @@
+#include <SphereCache.hpp>
+#include <common.h>
+#include <MeshOptimizer.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <tuple>
+
+std::map<SphereKey, std::weak_ptr<SphereMesh>> SphereCache::meshes;
+
+const int SphereLodChain::LevelSegments[SphereLodChain::LevelCount] = {100, 64, 40, 24, 16, 8};
+const float SphereLodChain::LevelMinScreenRadius[SphereLodChain::LevelCount] = {250, 120, 60, 25, 8, 0};
+const float SphereLodChain::Hysteresis = 0.15f;
+
+bool SphereKey::operator<(const SphereKey &o) const
+{
+    return std::tie(latitudeSegments, longitudeSegments)
+         < std::tie(o.latitudeSegments, o.longitudeSegments);
+}
+
+SphereMesh::SphereMesh(const std::vector<PackedSphereVertex> &data, const std::vector<unsigned int> &indices)
+    : range(SphereCache::Arena().Allocate(data.data(), data.size(), indices.data(), indices.size()))
+{
+}
+
+SphereMesh::~SphereMesh()
+{
+    SphereCache::Arena().Free(range);
+}
+
+GeometryArena& SphereCache::Arena()
+{
+    // Room for the default LOD chain before the first grow
+    static GeometryArena arena(sizeof(PackedSphereVertex), {
+        {0, 2, GL_SHORT, GL_TRUE, offsetof(PackedSphereVertex, normal)},
+        {1, 2, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(PackedSphereVertex, texCoords)},
+    }, 1 << 15, 1 << 17);
+    return arena;
+}
+
+SphereLodChain::SphereLodChain()
+{
+    for(int i=0;i<LevelCount;++i) {
+        levels.push_back(SphereCache::Get(SphereKey{LevelSegments[i], LevelSegments[i]}));
+    }
+}
+
+int SphereLodChain::SelectLevel(float screenRadius, int current)
+{
+    int target = LevelCount - 1;
+    for(int i=0;i<LevelCount;++i) {
+        if(screenRadius >= LevelMinScreenRadius[i]) {
+            target = i;
+            break;
+        }
+    }
+
+    if(target == current || current < 0 || current >= LevelCount) {
+        return target;
+    }
+
+    // Stay on the current level until the radius clearly leaves its band
+    const float lower = LevelMinScreenRadius[current] * (1 - Hysteresis);
+    const float upper = current > 0 ? LevelMinScreenRadius[current-1] * (1 + Hysteresis) : INFINITY;
+    if(screenRadius >= lower && screenRadius < upper) {
+        return current;
+    }
+
+    return target;
+}
+
+void SphereCache::generateVertexData(const SphereKey &key, std::vector<PackedSphereVertex> &data, std::vector<unsigned int> &indices)
+{
+    const int longitudeSegments = key.longitudeSegments;
+    const int latitudeSegments = key.latitudeSegments;
+
+    const float PI =  3.141592;
+
+    data.reserve((latitudeSegments+1) * (longitudeSegments+1));
+    indices.reserve(latitudeSegments * longitudeSegments * 6);
+
+    for(int i=0;i<=latitudeSegments;++i) {
+        for(int j=0;j<=longitudeSegments;++j) {
+            const float theta = (1.0*j / longitudeSegments)*2*PI;
+            const float phi = (1.0*i/latitudeSegments) * PI;
+
+            // on a unit sphere the position is the normal
+            const glm::vec3 normal(sin(phi)*cos(theta), cos(phi), sin(phi)*sin(theta));
+            const glm::vec2 oct = octEncode(normal);
+
+            PackedSphereVertex vertex;
+            vertex.normal[0] = packSnorm16(oct.x);
+            vertex.normal[1] = packSnorm16(oct.y);
+            vertex.texCoords[0] = packUnorm16(1.0*j / longitudeSegments);
+            vertex.texCoords[1] = packUnorm16(1.0*i / latitudeSegments);
+            data.push_back(vertex);
+        }
+    }
+
+    // Rows hold longitudeSegments+1 vertices, the last column duplicates the first for the texture seam
+    for(int i=0;i<latitudeSegments;++i) {
+        for(int j=0;j<longitudeSegments;++j) {
+            unsigned int topLeft = i * (longitudeSegments+1) + j;
+            unsigned int bottomLeft = topLeft + longitudeSegments + 1;
+            unsigned int topRight = topLeft + 1;
+            unsigned int bottomRight = bottomLeft + 1;
+
+            indices.push_back(bottomLeft);
+            indices.push_back(topLeft);
+            indices.push_back(bottomRight);
+
+            indices.push_back(topLeft);
+            indices.push_back(topRight);
+            indices.push_back(bottomRight);
+        }
+    }
+}
+
+std::shared_ptr<SphereMesh> SphereCache::Get(const SphereKey &key)
+{
+    std::shared_ptr<SphereMesh> mesh = meshes[key].lock();
+    if(mesh) {
+        return mesh;
+    }
+
+    std::vector<PackedSphereVertex> data;
+    std::vector<unsigned int> indices;
+    generateVertexData(key, data, indices);
+
+    // spheres are convex and drawn with back face culling, so only cache and fetch order matter
+    const VertexCacheStats before = analyzeVertexCache(indices, data.size());
+    optimizeVertexCache(indices, data.size());
+    optimizeVertexFetch(data, indices);
+    printOptimizationReport("sphere " + std::to_string(key.latitudeSegments) + "x" + std::to_string(key.longitudeSegments),
+                            data.size(), data.size(), before, analyzeVertexCache(indices, data.size()));
+
+    mesh = std::make_shared<SphereMesh>(data, indices);
+    meshes[key] = mesh;
+    return mesh;
+}
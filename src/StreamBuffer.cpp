@@ -0,0 +1,137 @@
+#include <StreamBuffer.hpp>
+#include <GLExtensions.hpp>
+#include <common.h>
+
+namespace {
+    size_t queryAlignment(GLenum name)
+    {
+        GLint alignment = 0;
+        glGetIntegerv(name, &alignment);
+        return alignment > 0 ? alignment : 256;
+    }
+}
+
+StreamBuffer::StreamBuffer(size_t frameBytes)
+    : persistent(GLExtensions::HasBufferStorage),
+      frameBytes(frameBytes),
+      frame(0),
+      head(0),
+      mapped(nullptr),
+      mappedOffset(0),
+      stalls(0),
+      overflowReported(false)
+{
+    for(unsigned int i = 0; i < FrameCount; ++i) {
+        fences[i] = nullptr;
+    }
+
+    GL_ERROR_CHECK(glGenBuffers(1, &buffer));
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, buffer));
+    if(persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GL_ERROR_CHECK(GLExtensions::BufferStorage(GL_ARRAY_BUFFER, frameBytes * FrameCount, nullptr, flags));
+        mapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, frameBytes * FrameCount, flags);
+        if(!mapped) {
+            std::cout << "ERROR::STREAM_BUFFER: persistent mapping failed" << std::endl;
+        }
+    }
+    else {
+        GL_ERROR_CHECK(glBufferData(GL_ARRAY_BUFFER, frameBytes * FrameCount, nullptr, GL_STREAM_DRAW));
+    }
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for(unsigned int i = 0; i < FrameCount; ++i) {
+        if(fences[i]) {
+            glDeleteSync(fences[i]);
+        }
+    }
+    // deleting a mapped buffer unmaps it
+    glDeleteBuffers(1, &buffer);
+}
+
+size_t StreamBuffer::UniformAlignment()
+{
+    static const size_t alignment = queryAlignment(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT);
+    return alignment;
+}
+
+size_t StreamBuffer::StorageAlignment()
+{
+    static const size_t alignment = queryAlignment(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT);
+    return alignment;
+}
+
+void StreamBuffer::BeginFrame()
+{
+    frame = (frame + 1) % FrameCount;
+    head = 0;
+    overflowReported = false;
+
+    GLsync &fence = fences[frame];
+    if(!fence) {
+        return;
+    }
+
+    // the first check does not wait, anything else means the GPU is a whole ring behind
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if(status == GL_TIMEOUT_EXPIRED) {
+        ++stalls;
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        } while(status == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+StreamAllocation StreamBuffer::Allocate(size_t bytes, size_t alignment)
+{
+    const size_t offset = (head + alignment - 1) & ~(alignment - 1);
+    if(offset + bytes > frameBytes) {
+        if(!overflowReported) {
+            std::cout << "ERROR::STREAM_BUFFER: the " << frameBytes << " byte frame region is full" << std::endl;
+            overflowReported = true;
+        }
+        return StreamAllocation{0, nullptr};
+    }
+    head = offset + bytes;
+
+    if(!persistent && !mapped) {
+        // nothing else in the region past offset is written this frame and the fence
+        // guarantees the GPU is done with it, so neither synchronization nor old contents are needed
+        mappedOffset = regionOffset() + offset;
+        GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, buffer));
+        mapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, mappedOffset, frameBytes - offset,
+                                                  GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+                                                  | GL_MAP_INVALIDATE_RANGE_BIT);
+        GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    }
+    if(!mapped) {
+        return StreamAllocation{0, nullptr};
+    }
+
+    const size_t bufferOffset = regionOffset() + offset;
+    const size_t mappedStart = persistent ? 0 : mappedOffset;
+    return StreamAllocation{bufferOffset, mapped + (bufferOffset - mappedStart)};
+}
+
+void StreamBuffer::Commit()
+{
+    // coherent persistent writes are visible to commands issued after them
+    if(persistent || !mapped) {
+        return;
+    }
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, buffer));
+    GL_ERROR_CHECK(glUnmapBuffer(GL_ARRAY_BUFFER));
+    GL_ERROR_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    mapped = nullptr;
+}
+
+void StreamBuffer::EndFrame()
+{
+    Commit();
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,266 @@
+#include <TextureArray.hpp>
+#include <GLExtensions.hpp>
+#include <KtxFile.hpp>
+#include <RenderState.hpp>
+#include <ResidencyManager.hpp>
+#include <common.h>
+#include <learnopengl/shader.h>
+
+#include <algorithm>
+
+TextureArray::TextureArray(GLsizei width, GLsizei height, GLsizei capacity, GLenum internalFormat)
+    : internalFormat(internalFormat),
+      width(width),
+      height(height),
+      capacity(std::max(capacity, 1)),
+      layers(0),
+      levels(1)
+{
+    while((std::max(width, height) >> levels) > 0) {
+        ++levels;
+    }
+
+    texture = allocate(width, height, levels, this->capacity, internalFormat);
+    GL_ERROR_CHECK(glGenFramebuffers(1, &drawFramebuffer));
+    GL_ERROR_CHECK(glGenVertexArrays(1, &copyVertexArray));
+}
+
+Shader& TextureArray::copyShader()
+{
+    // never freed, it lives as long as the context
+    static Shader *shader = nullptr;
+    if(!shader) {
+        shader = new Shader("resources/shaders/texture_copy.vs", "resources/shaders/texture_copy.fs");
+        shader->use();
+        shader->setInt("source", 0);
+    }
+    return *shader;
+}
+
+unsigned int TextureArray::allocate(GLsizei width, GLsizei height, GLsizei levels, GLsizei capacity,
+                                    GLenum internalFormat)
+{
+    unsigned int texture;
+    GL_ERROR_CHECK(glGenTextures(1, &texture));
+    RenderState::BindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+    // GL 3.3 has no immutable storage, every level is allocated by hand
+    for(GLsizei level = 0; level < levels; ++level) {
+        specifyLevel(level, width, height, capacity, internalFormat);
+    }
+    GL_ERROR_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT));
+    GL_ERROR_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT));
+    GL_ERROR_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+    GL_ERROR_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GL_ERROR_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1));
+    return texture;
+}
+
+void TextureArray::specifyLevel(GLsizei level, GLsizei width, GLsizei height, GLsizei capacity, GLenum internalFormat)
+{
+    const GLsizei levelWidth = std::max(width >> level, 1), levelHeight = std::max(height >> level, 1);
+    if(internalFormat != GL_RGBA8) {
+        const GLsizei bytes = ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * KtxFile::BlockBytes(internalFormat)
+                              * capacity;
+        GL_ERROR_CHECK(glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, levelWidth, levelHeight,
+                                              capacity, 0, bytes, nullptr));
+    }
+    else {
+        GL_ERROR_CHECK(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, levelWidth, levelHeight, capacity, 0,
+                                    GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+    }
+}
+
+void TextureArray::grow()
+{
+    const unsigned int grown = allocate(width, height, levels, capacity * 2, internalFormat);
+
+    const unsigned int previous = texture;
+    texture = grown;
+    // compressed textures cannot be blitted and the finer levels may have been dropped,
+    // so the layers are read or copied again at full size
+    for(GLsizei layer = 0; layer < layers; ++layer) {
+        if(!Compressed()) {
+            fill(layer, 0);
+        }
+        else if(!loadLayer(layer, bakedLayers[layer], 0, levels)) {
+            std::cout << "ERROR::TEXTURE_ARRAY: " << bakedLayers[layer].path << " changed, layer " << layer
+                      << " is left empty" << std::endl;
+        }
+    }
+    RenderState::ForgetTexture(previous);
+    glDeleteTextures(1, &previous);
+    capacity *= 2;
+}
+
+TextureArray::~TextureArray()
+{
+    RenderState::ForgetTexture(texture);
+    glDeleteTextures(1, &texture);
+    glDeleteFramebuffers(1, &drawFramebuffer);
+    RenderState::ForgetVertexArray(copyVertexArray);
+    glDeleteVertexArrays(1, &copyVertexArray);
+}
+
+GLenum TextureArray::BakedFormatOf(const std::string &bakedPath, GLsizei width, GLsizei height, bool flipVertically)
+{
+    KtxFile ktx;
+    if(!GLExtensions::HasTextureCompressionS3TC || !ktx.Read(bakedPath, true) || ktx.faces != 1
+       || (GLsizei)ktx.width != width || (GLsizei)ktx.height != height
+       || ktx.orientation != (flipVertically ? KtxFile::OrientationUp : KtxFile::OrientationDown)) {
+        return GL_RGBA8;
+    }
+    return ktx.internalFormat;
+}
+
+glm::ivec2 TextureArray::SizeOf(unsigned int texture)
+{
+    glm::ivec2 size(0);
+    RenderState::BindTexture(0, GL_TEXTURE_2D, texture);
+    GL_ERROR_CHECK(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &size.x));
+    GL_ERROR_CHECK(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &size.y));
+    return size;
+}
+
+void TextureArray::bindLayer(GLsizei layer, GLsizei level)
+{
+    GL_ERROR_CHECK(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer));
+    GL_ERROR_CHECK(glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, level, layer));
+}
+
+GLsizei TextureArray::residentLevel() const
+{
+    return ResidencyManager::Shared().ResidentLevel(texture);
+}
+
+void TextureArray::fill(GLsizei layer, GLsizei level)
+{
+    const CopiedLayer &copied = copiedLayers[layer];
+    bindLayer(layer, level);
+    if(copied.source == 0) {
+        GL_ERROR_CHECK(glClearBufferfv(GL_COLOR, 0, &copied.color[0]));
+        GL_ERROR_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+        return;
+    }
+
+    // compressed textures cannot be attached to a framebuffer, so instead of blitting the source
+    // is drawn into the layer, which converts the format and resamples bilinearly in one pass
+    const RenderState::Saved saved = RenderState::Save();
+    RenderState::SetDepthTest(false);
+    RenderState::SetBlend(false);
+    RenderState::SetCullFace(false);
+
+    RenderState::SetViewport(0, 0, std::max(width >> level, 1), std::max(height >> level, 1));
+    copyShader().use();
+    RenderState::BindVertexArray(copyVertexArray);
+    RenderState::BindTexture(0, GL_TEXTURE_2D, copied.source);
+    GL_ERROR_CHECK(glDrawArrays(GL_TRIANGLES, 0, 3));
+
+    GL_ERROR_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    RenderState::Restore(saved);
+}
+
+int TextureArray::Add(unsigned int source)
+{
+    if(Compressed()) {
+        std::cout << "ERROR::TEXTURE_ARRAY: textures cannot be drawn into a compressed array" << std::endl;
+        return -1;
+    }
+    if(layers == capacity) {
+        grow();
+    }
+
+    copiedLayers.push_back(CopiedLayer{source, glm::vec4(0.0f)});
+    fill(layers, residentLevel());
+    return layers++;
+}
+
+void TextureArray::Replace(int layer, unsigned int source)
+{
+    if(!Compressed() && layer >= 0 && layer < layers) {
+        copiedLayers[layer].source = source;
+        fill(layer, residentLevel());
+    }
+}
+
+int TextureArray::AddColor(const glm::vec4 &color)
+{
+    if(Compressed()) {
+        std::cout << "ERROR::TEXTURE_ARRAY: colors cannot be drawn into a compressed array" << std::endl;
+        return -1;
+    }
+    if(layers == capacity) {
+        grow();
+    }
+
+    copiedLayers.push_back(CopiedLayer{0, color});
+    fill(layers, residentLevel());
+    return layers++;
+}
+
+void TextureArray::GenerateMipmaps()
+{
+    if(Compressed()) {
+        return;
+    }
+    RenderState::BindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+    GL_ERROR_CHECK(glGenerateMipmap(GL_TEXTURE_2D_ARRAY));
+}
+
+bool TextureArray::loadLayer(GLsizei layer, const BakedLayer &baked, GLsizei first, GLsizei last)
+{
+    KtxFile ktx;
+    if(!ktx.Read(baked.path) || ktx.internalFormat != internalFormat || ktx.faces != 1
+       || (GLsizei)ktx.width != width || (GLsizei)ktx.height != height || (GLsizei)ktx.Levels() < levels
+       || ktx.orientation != (baked.flipVertically ? KtxFile::OrientationUp : KtxFile::OrientationDown)) {
+        return false;
+    }
+    RenderState::BindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+    for(GLsizei level = first; level < last; ++level) {
+        const std::vector<unsigned char> &data = ktx.data[level][0];
+        GL_ERROR_CHECK(glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, ktx.LevelWidth(level),
+                                                 ktx.LevelHeight(level), 1, internalFormat, data.size(), &data[0]));
+    }
+    return true;
+}
+
+int TextureArray::AddBaked(const std::string &bakedPath, bool flipVertically)
+{
+    if(!Compressed()) {
+        return -1;
+    }
+    if(layers == capacity) {
+        grow();
+    }
+
+    const BakedLayer baked{bakedPath, flipVertically};
+    if(!loadLayer(layers, baked, residentLevel(), levels)) {
+        return -1;
+    }
+    bakedLayers.push_back(baked);
+    return layers++;
+}
+
+bool TextureArray::LoadLevels(GLsizei first, GLsizei last)
+{
+    RenderState::BindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+    for(GLsizei level = first; level < last; ++level) {
+        specifyLevel(level, width, height, capacity, internalFormat);
+    }
+
+    if(!Compressed()) {
+        // the level drawn into has to be inside the base..max range for the framebuffer to be complete
+        GL_ERROR_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, first));
+        for(GLsizei layer = 0; layer < layers; ++layer) {
+            fill(layer, first);
+        }
+        RenderState::BindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+        GL_ERROR_CHECK(glGenerateMipmap(GL_TEXTURE_2D_ARRAY));
+        return true;
+    }
+    for(GLsizei layer = 0; layer < layers; ++layer) {
+        if(!loadLayer(layer, bakedLayers[layer], first, last)) {
+            return false;
+        }
+    }
+    return true;
+}
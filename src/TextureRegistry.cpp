@@ -0,0 +1,182 @@
+#include <TextureRegistry.hpp>
+#include <CompressedTexture.hpp>
+#include <KtxFile.hpp>
+#include <RenderState.hpp>
+#include <ResidencyManager.hpp>
+#include <TextureStreamer.hpp>
+#include <common.h>
+
+#include <climits>
+#include <cstdlib>
+
+namespace {
+    // Collapses empty and . components and folds .. into the component before it
+    std::string normalizePath(const std::string &path)
+    {
+        const bool absolute = !path.empty() && path[0] == '/';
+        std::vector<std::string> components;
+        size_t start = 0;
+        while(start <= path.size()) {
+            size_t end = path.find('/', start);
+            if(end == std::string::npos) {
+                end = path.size();
+            }
+            const std::string component = path.substr(start, end - start);
+            if(component == "..") {
+                if(!components.empty() && components.back() != "..") {
+                    components.pop_back();
+                }
+                else if(!absolute) {
+                    components.push_back(component);
+                }
+            }
+            else if(!component.empty() && component != ".") {
+                components.push_back(component);
+            }
+            start = end + 1;
+        }
+
+        std::string normalized = absolute ? "/" : "";
+        for(size_t i = 0; i < components.size(); ++i) {
+            normalized += (i ? "/" : "") + components[i];
+        }
+        return normalized.empty() ? "." : normalized;
+    }
+}
+
+TextureRegistry& TextureRegistry::Shared()
+{
+    static TextureRegistry *registry = new TextureRegistry();
+    return *registry;
+}
+
+std::string TextureRegistry::CanonicalPath(const std::string &path)
+{
+    char resolved[PATH_MAX];
+    if(realpath(path.c_str(), resolved)) {
+        return resolved;
+    }
+    return normalizePath(path);
+}
+
+size_t TextureRegistry::KeyHash::operator()(const Key &key) const
+{
+    return hashBytes(key.path.data(), key.path.size(), hashBytes(&key.flags, sizeof(key.flags)));
+}
+
+template <typename Load>
+unsigned int TextureRegistry::acquire(const Key &key, Load load)
+{
+    auto it = textureOf.find(key);
+    if(it != textureOf.end()) {
+        ++entries[it->second].references;
+        ++hits;
+        return it->second;
+    }
+
+    bool hasAlpha = false;
+    const unsigned int texture = load(hasAlpha);
+    if(texture == 0) {
+        return 0;
+    }
+    ++loads;
+    textureOf[key] = texture;
+    entries[texture] = Entry{key, 1, hasAlpha};
+
+    // a streamed texture only knows after its decode
+    TextureStreamer::Shared().WhenReady(texture, [this](unsigned int texture, bool hasAlpha) {
+        auto entry = entries.find(texture);
+        if(entry != entries.end()) {
+            entry->second.hasAlpha = hasAlpha;
+        }
+    });
+    return texture;
+}
+
+unsigned int TextureRegistry::Acquire(const std::string &path, unsigned int flags)
+{
+    const Key key{CanonicalPath(path), flags & ~(unsigned int)TextureCubeMap};
+    return acquire(key, [&path, flags](bool &hasAlpha) {
+        const GLenum wrap = flags & TextureClampToEdge ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+
+        const bool flip = (flags & TextureFlipVertically) != 0;
+
+        // baked by asset_baker, only used when it was baked in the orientation asked for
+        const std::string bakedPath = KtxFile::BakedPath(path);
+        unsigned int texture = loadCompressedTexture(bakedPath, GL_TEXTURE_2D, flip, &hasAlpha);
+        if(texture) {
+            GL_ERROR_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap));
+            GL_ERROR_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap));
+            ResidencyManager::Shared().Track(texture, GL_TEXTURE_2D, {path}, bakedPath, flip);
+            return texture;
+        }
+
+        TextureLoadOptions options;
+        options.flipVertically = flip;
+        options.wrap = wrap;
+        texture = TextureStreamer::Shared().Load(path, options);
+        ResidencyManager::Shared().Track(texture, GL_TEXTURE_2D, {path}, "", flip);
+        return texture;
+    });
+}
+
+unsigned int TextureRegistry::AcquireCubeMap(const std::vector<std::string> &faces, const std::string &bakedPath)
+{
+    Key key{"", TextureCubeMap};
+    for(const std::string &face : faces) {
+        key.path += CanonicalPath(face) + "\n";
+    }
+    return acquire(key, [&faces, &bakedPath](bool &hasAlpha) {
+        unsigned int texture = bakedPath.empty() ? 0 : loadCompressedTexture(bakedPath, GL_TEXTURE_CUBE_MAP, false, &hasAlpha);
+        if(texture) {
+            GL_ERROR_CHECK(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+            GL_ERROR_CHECK(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+            GL_ERROR_CHECK(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE));
+            ResidencyManager::Shared().Track(texture, GL_TEXTURE_CUBE_MAP, faces, bakedPath, false);
+            return texture;
+        }
+
+        TextureLoadOptions options;
+        options.placeholder[0] = options.placeholder[1] = options.placeholder[2] = 0;
+        texture = TextureStreamer::Shared().LoadCubeMap(faces, options);
+        ResidencyManager::Shared().Track(texture, GL_TEXTURE_CUBE_MAP, faces, "", false);
+        return texture;
+    });
+}
+
+void TextureRegistry::AddRef(unsigned int texture)
+{
+    auto it = entries.find(texture);
+    if(it != entries.end()) {
+        ++it->second.references;
+    }
+}
+
+void TextureRegistry::Release(unsigned int texture)
+{
+    auto it = entries.find(texture);
+    if(it == entries.end()) {
+        if(texture != 0) {
+            std::cout << "ERROR::TEXTURE_REGISTRY: releasing texture " << texture << " which it does not hold"
+                      << std::endl;
+        }
+        return;
+    }
+    if(--it->second.references > 0) {
+        return;
+    }
+
+    // the streamer must not upload into a name GL may hand out again
+    TextureStreamer::Shared().Cancel(texture);
+    ResidencyManager::Shared().Untrack(texture);
+    textureOf.erase(it->second.key);
+    entries.erase(it);
+    RenderState::ForgetTexture(texture);
+    glDeleteTextures(1, &texture);
+}
+
+bool TextureRegistry::HasAlpha(unsigned int texture) const
+{
+    auto it = entries.find(texture);
+    return it != entries.end() && it->second.hasAlpha;
+}
@@ -0,0 +1,328 @@
+#include <TextureStreamer.hpp>
+#include <RenderState.hpp>
+#include <common.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    GLenum internalFormatOf(int channels)
+    {
+        switch(channels) {
+            case 1: return GL_R8;
+            case 2: return GL_RG8;
+            case 3: return GL_RGB8;
+            default: return GL_RGBA8;
+        }
+    }
+
+    GLenum formatOf(int channels)
+    {
+        switch(channels) {
+            case 1: return GL_RED;
+            case 2: return GL_RG;
+            case 3: return GL_RGB;
+            default: return GL_RGBA;
+        }
+    }
+
+    size_t rowBytesOf(const DecodedImage &image)
+    {
+        return (size_t)image.width * image.channels;
+    }
+}
+
+TextureStreamer::TextureStreamer(size_t frameBudget)
+    : ring(frameBudget),
+      pendingBytes(0),
+      uploadedBytes(0),
+      frameUploadedBytes(0),
+      completed(0)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    for(Upload &upload : uploads) {
+        ImageDecodePool::FreePixels(upload.image.pixels);
+    }
+}
+
+TextureStreamer& TextureStreamer::Shared()
+{
+    // never freed, the ring has to go before the context does and the decodes may outlive main
+    static TextureStreamer *streamer = new TextureStreamer();
+    return *streamer;
+}
+
+unsigned int TextureStreamer::create(GLenum target, const TextureLoadOptions &options)
+{
+    unsigned int texture;
+    GL_ERROR_CHECK(glGenTextures(1, &texture));
+    RenderState::BindTexture(0, target, texture);
+
+    const unsigned int faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    for(unsigned int face = 0; face < faces; ++face) {
+        const GLenum faceTarget = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+        GL_ERROR_CHECK(glTexImage2D(faceTarget, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, options.placeholder));
+    }
+    GL_ERROR_CHECK(glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0));
+    GL_ERROR_CHECK(glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, 0));
+    GL_ERROR_CHECK(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+    GL_ERROR_CHECK(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GL_ERROR_CHECK(glTexParameteri(target, GL_TEXTURE_WRAP_S, options.wrap));
+    GL_ERROR_CHECK(glTexParameteri(target, GL_TEXTURE_WRAP_T, options.wrap));
+    if(target == GL_TEXTURE_CUBE_MAP) {
+        GL_ERROR_CHECK(glTexParameteri(target, GL_TEXTURE_WRAP_R, options.wrap));
+    }
+
+    std::shared_ptr<StreamedTexture> streamed(new StreamedTexture());
+    streamed->texture = texture;
+    streamed->target = target;
+    streamed->facesLeft = faces;
+    std::memcpy(streamed->placeholder, options.placeholder, sizeof(streamed->placeholder));
+    textures[texture] = streamed;
+    return texture;
+}
+
+unsigned int TextureStreamer::Load(const std::string &path, const TextureLoadOptions &options)
+{
+    const unsigned int texture = create(GL_TEXTURE_2D, options);
+    std::shared_ptr<StreamedTexture> streamed = textures[texture];
+    ImageDecodePool::Shared().Decode(path, options.flipVertically, [this, streamed](DecodedImage &image) {
+        decoded(streamed, GL_TEXTURE_2D, image);
+    });
+    return texture;
+}
+
+unsigned int TextureStreamer::LoadCubeMap(const std::vector<std::string> &faces, const TextureLoadOptions &options)
+{
+    TextureLoadOptions cubeOptions = options;
+    cubeOptions.wrap = GL_CLAMP_TO_EDGE;
+    const unsigned int texture = create(GL_TEXTURE_CUBE_MAP, cubeOptions);
+    std::shared_ptr<StreamedTexture> streamed = textures[texture];
+    if(faces.size() != 6) {
+        std::cout << "ERROR::TEXTURE_STREAMER: a cube map needs 6 faces, got " << faces.size() << std::endl;
+        fail(*streamed);
+        return texture;
+    }
+    for(unsigned int face = 0; face < faces.size(); ++face) {
+        const GLenum faceTarget = GL_TEXTURE_CUBE_MAP_POSITIVE_X + face;
+        ImageDecodePool::Shared().Decode(faces[face], false, [this, streamed, faceTarget](DecodedImage &image) {
+            decoded(streamed, faceTarget, image);
+        });
+    }
+    return texture;
+}
+
+bool TextureStreamer::Reload(unsigned int texture, GLenum target, const std::vector<std::string> &paths,
+                             bool flipVertically, int level, TextureReady ready)
+{
+    if(textures.count(texture) || paths.empty()) {
+        return false;
+    }
+
+    std::shared_ptr<StreamedTexture> streamed(new StreamedTexture());
+    streamed->texture = texture;
+    streamed->target = target;
+    streamed->level = level;
+    streamed->reload = true;
+    streamed->facesLeft = paths.size();
+    streamed->ready.push_back(std::move(ready));
+    textures[texture] = streamed;
+
+    for(unsigned int face = 0; face < paths.size(); ++face) {
+        const GLenum faceTarget = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+        // the worker scales the image down to the level
+        ImageDecodePool::Shared().Decode(paths[face], flipVertically, [this, streamed, faceTarget](DecodedImage &image) {
+            decoded(streamed, faceTarget, image);
+        }, level);
+    }
+    return true;
+}
+
+bool TextureStreamer::WhenReady(unsigned int texture, TextureReady ready)
+{
+    auto it = textures.find(texture);
+    if(it == textures.end()) {
+        return false;
+    }
+    it->second->ready.push_back(std::move(ready));
+    return true;
+}
+
+void TextureStreamer::Cancel(unsigned int texture)
+{
+    auto it = textures.find(texture);
+    if(it != textures.end()) {
+        fail(*it->second);
+    }
+}
+
+void TextureStreamer::decoded(const std::shared_ptr<StreamedTexture> &texture, GLenum faceTarget, DecodedImage &image)
+{
+    if(texture->failed) {
+        return;
+    }
+    if(!image.pixels) {
+        fail(*texture);
+        return;
+    }
+
+    if(!texture->allocated) {
+        allocate(*texture, image);
+    }
+    else if(image.width != texture->width || image.height != texture->height) {
+        std::cout << "ERROR::TEXTURE_STREAMER: " << image.path << " is " << image.width << "x" << image.height
+                  << ", the other faces are " << texture->width << "x" << texture->height << std::endl;
+        fail(*texture);
+        return;
+    }
+    texture->hasAlpha = texture->hasAlpha || image.channels == 4;
+
+    // the pixels stay around until their last row is in the ring
+    uploads.push_back(Upload{texture, faceTarget, image, 0});
+    pendingBytes += rowBytesOf(image) * image.height;
+    image.pixels = nullptr;
+}
+
+void TextureStreamer::allocate(StreamedTexture &texture, const DecodedImage &image)
+{
+    texture.allocated = true;
+    texture.width = image.width;
+    texture.height = image.height;
+
+    const GLenum internalFormat = internalFormatOf(image.channels);
+    const unsigned int faces = texture.target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    RenderState::BindTexture(0, texture.target, texture.texture);
+
+    // the base level already points past it, so it fills up unseen like a new texture's level 0
+    if(texture.reload) {
+        for(unsigned int face = 0; face < faces; ++face) {
+            const GLenum faceTarget = texture.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face
+                                                                            : texture.target;
+            GL_ERROR_CHECK(glTexImage2D(faceTarget, texture.level, internalFormat, image.width, image.height, 0,
+                                        formatOf(image.channels), GL_UNSIGNED_BYTE, nullptr));
+        }
+        return;
+    }
+
+    // the smallest level of the final chain is 1x1 like the placeholder, so it can hold it meanwhile
+    int smallest = 0;
+    while((std::max(image.width, image.height) >> (smallest + 1)) > 0) {
+        ++smallest;
+    }
+
+    for(unsigned int face = 0; face < faces; ++face) {
+        const GLenum faceTarget = texture.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face
+                                                                        : texture.target;
+        GL_ERROR_CHECK(glTexImage2D(faceTarget, smallest, internalFormat, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                                    texture.placeholder));
+        GL_ERROR_CHECK(glTexImage2D(faceTarget, 0, internalFormat, image.width, image.height, 0,
+                                    formatOf(image.channels), GL_UNSIGNED_BYTE, nullptr));
+    }
+    // levels outside base..max do not count for completeness, level 0 can fill up unseen
+    GL_ERROR_CHECK(glTexParameteri(texture.target, GL_TEXTURE_BASE_LEVEL, smallest));
+    GL_ERROR_CHECK(glTexParameteri(texture.target, GL_TEXTURE_MAX_LEVEL, smallest));
+}
+
+void TextureStreamer::complete(StreamedTexture &texture)
+{
+    RenderState::BindTexture(0, texture.target, texture.texture);
+    GL_ERROR_CHECK(glTexParameteri(texture.target, GL_TEXTURE_BASE_LEVEL, texture.level));
+    GL_ERROR_CHECK(glTexParameteri(texture.target, GL_TEXTURE_MAX_LEVEL, 1000));
+    GL_ERROR_CHECK(glGenerateMipmap(texture.target));
+
+    textures.erase(texture.texture);
+    ++completed;
+    for(TextureReady &ready : texture.ready) {
+        ready(texture.texture, texture.hasAlpha);
+    }
+    texture.ready.clear();
+}
+
+void TextureStreamer::fail(StreamedTexture &texture)
+{
+    texture.failed = true;
+    texture.ready.clear();
+    textures.erase(texture.texture);
+}
+
+void TextureStreamer::Update()
+{
+    ImageDecodePool::Shared().Poll();
+
+    ring.BeginFrame();
+    frameUploadedBytes = 0;
+
+    // copy as many rows as the frame's region holds, an image may take several frames
+    while(!uploads.empty()) {
+        Upload &upload = uploads.front();
+        const size_t rowBytes = rowBytesOf(upload.image);
+        const size_t remainingBytes = (size_t)(upload.image.height - upload.nextRow) * rowBytes;
+
+        if(!upload.texture->failed) {
+            const size_t used = (ring.UsedBytes() + 3) & ~(size_t)3;
+            const size_t available = ring.FrameBytes() > used ? ring.FrameBytes() - used : 0;
+            const int rows = std::min<size_t>(upload.image.height - upload.nextRow, available / rowBytes);
+            if(rows == 0 && ring.UsedBytes() > 0) {
+                break;
+            }
+            if(rows == 0) {
+                std::cout << "ERROR::TEXTURE_STREAMER: a row of " << upload.image.path << " is larger than the "
+                          << ring.FrameBytes() << " byte frame budget" << std::endl;
+                fail(*upload.texture);
+            }
+            else {
+                const StreamAllocation allocation = ring.Allocate(rows * rowBytes, 4);
+                if(!allocation.pointer) {
+                    break;
+                }
+                std::memcpy(allocation.pointer, upload.image.pixels + upload.nextRow * rowBytes, rows * rowBytes);
+                copies.push_back(RowCopy{upload.texture->texture, upload.texture->target, upload.faceTarget,
+                                         formatOf(upload.image.channels), upload.texture->level, upload.nextRow, rows,
+                                         upload.image.width, allocation.offset});
+                upload.nextRow += rows;
+                pendingBytes -= rows * rowBytes;
+                frameUploadedBytes += rows * rowBytes;
+                if(upload.nextRow < upload.image.height) {
+                    continue;
+                }
+                if(--upload.texture->facesLeft == 0) {
+                    finished.push_back(upload.texture);
+                }
+            }
+        }
+        else {
+            pendingBytes -= remainingBytes;
+        }
+
+        ImageDecodePool::FreePixels(upload.image.pixels);
+        uploads.pop_front();
+    }
+    ring.Commit();
+    uploadedBytes += frameUploadedBytes;
+
+    if(!copies.empty()) {
+        // the ring's rows are tightly packed
+        GL_ERROR_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring.Id()));
+        GL_ERROR_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        for(const RowCopy &copy : copies) {
+            RenderState::BindTexture(0, copy.target, copy.texture);
+            GL_ERROR_CHECK(glTexSubImage2D(copy.faceTarget, copy.level, 0, copy.firstRow, copy.width, copy.rows, copy.format,
+                                           GL_UNSIGNED_BYTE, (void*)copy.offset));
+        }
+        GL_ERROR_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+        GL_ERROR_CHECK(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+        copies.clear();
+    }
+
+    for(std::shared_ptr<StreamedTexture> &texture : finished) {
+        if(!texture->failed) {
+            complete(*texture);
+        }
+    }
+    finished.clear();
+
+    ring.EndFrame();
+}
@@ -0,0 +1,44 @@
+#include <VertexPacking.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+glm::vec2 octEncode(glm::vec3 n)
+{
+    const float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if(l1 == 0) {
+        return glm::vec2(0, 0);
+    }
+    n /= l1;
+
+    glm::vec2 e(n.x, n.y);
+    if(n.z < 0) {
+        e.x = (1 - std::fabs(n.y)) * (n.x >= 0 ? 1 : -1);
+        e.y = (1 - std::fabs(n.x)) * (n.y >= 0 ? 1 : -1);
+    }
+    return e;
+}
+
+int16_t packSnorm16(float value)
+{
+    return (int16_t)std::round(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f);
+}
+
+uint16_t packUnorm16(float value)
+{
+    return (uint16_t)std::round(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f);
+}
+
+static uint32_t packSnorm10(float value)
+{
+    const int v = (int)std::round(std::min(std::max(value, -1.0f), 1.0f) * 511.0f);
+    return (uint32_t)v & 0x3ff;
+}
+
+uint32_t packTangent(glm::vec3 tangent, float bitangentSign)
+{
+    const glm::vec2 e = octEncode(tangent);
+    // 2 bit snorm w: 1 is +1, 3 is -1
+    const uint32_t w = bitangentSign < 0 ? 3 : 1;
+    return packSnorm10(e.x) | (packSnorm10(e.y) << 10) | (w << 30);
+}
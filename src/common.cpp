@@ -6,3 +6,13 @@ std::string readFileContents(std::string path) {
     buffer << in.rdbuf();
     return buffer.str();
 }
+
+size_t hashBytes(const void *data, size_t size, size_t seed) {
+    const unsigned char *bytes = (const unsigned char*)data;
+    uint64_t hash = seed;
+    for(size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return (size_t)hash;
+}
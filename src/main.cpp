@@ -14,6 +14,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/constants.hpp>
 
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader.h>
@@ -25,6 +26,22 @@
 
 #include <Skybox.hpp>
 #include <Planet.hpp>
+#include <PlanetRenderer.hpp>
+#include <RenderState.hpp>
+#include <Culling.hpp>
+#include <FrameUniforms.hpp>
+#include <GLExtensions.hpp>
+#include <ProgramCache.hpp>
+#include <ShaderPermutations.hpp>
+#include <ShaderBuildQueue.hpp>
+#include <ShaderHotReload.hpp>
+#include <IndirectModel.hpp>
+#include <StreamBuffer.hpp>
+#include <ImageDecodePool.hpp>
+#include <TextureStreamer.hpp>
+#include <TextureRegistry.hpp>
+#include <ResidencyManager.hpp>
+#include <RenderQueue.hpp>
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
@@ -44,6 +61,11 @@ float orbitModifier = 1.0f;
 float sunScaleModifier = 0;
 float orbitScaleModifier = 1;
 
+// number of extra bodies spawned with --bench
+const unsigned int BENCH_BODIES = 10000;
+// backpacks per side of the cube of copies drawn with --bench
+const unsigned int BENCH_BACKPACK_GRID = 10;
+
 // camera
 
 float lastX = SCR_WIDTH / 2.0f;
@@ -142,34 +164,74 @@ class Planet
     float scale;
     float planetMass;
     bool sunPlanet;
+    glm::mat4 planetModelMat;
+    int layer;
+    int lodLevel;
+    // radius covered on screen in pixels, from UpdateLod
+    float screenRadius;
+    Shader *queuedShader;
+    // this frame's ObjectData block, written by Queue
+    unsigned int objectBuffer;
+    size_t objectOffset;
+
+    // RenderQueue callback for bodies drawn on their own
+    static void drawPacket(void *object, unsigned int, unsigned int)
+    {
+        Planet &planet = *(Planet*)object;
+        RenderState::SetCullFace(true, GL_BACK);
+        planet.Draw(*planet.queuedShader);
+    }
 
 public:
 
     Planet(string const texturePath, float a, float b, float scale = 0.1, float mass = 0.01, bool sunPlanet = false)
-        : texturePath(texturePath),
+        : orbit(PlanetOrbit(a,b)),
           model(texturePath),
-          orbit(PlanetOrbit(a,b)),
+          texturePath(texturePath),
           position(glm::vec3(0,0,0)),
           scale(scale),
+          planetMass(mass),
           sunPlanet(sunPlanet),
-          planetMass(mass) {}
+          planetModelMat(1.0f),
+          layer(-1),
+          lodLevel(-1),
+          screenRadius(0),
+          queuedShader(nullptr),
+          objectBuffer(0),
+          objectOffset(0) {}
 
     Planet(const Planet& o)
-        : texturePath(texturePath),
-          orbit(PlanetOrbit(o.orbit.a,o.orbit.b)),
+        : Planet(o, o.orbit.a, o.orbit.b) {}
+
+    // Shares the model (sphere and texture) of o but orbits on its own ellipse
+    Planet(const Planet& o, float a, float b)
+        : orbit(PlanetOrbit(a,b)),
+          model(o.model),
+          texturePath(o.texturePath),
           position(o.position),
           scale(o.scale),
-          planetMass(o.planetMass) {}
+          planetMass(o.planetMass),
+          sunPlanet(o.sunPlanet),
+          planetModelMat(1.0f),
+          layer(o.layer),
+          lodLevel(-1),
+          screenRadius(0),
+          queuedShader(nullptr),
+          objectBuffer(0),
+          objectOffset(0) {}
 
     PlanetModel& getModel() { return model; }
     const glm::vec3& getPosition() const { return position; }
     float getMass() const { return planetMass; }
+    void setLayer(int l) { layer = l; }
+    const string& getTexturePath() const { return texturePath; }
+    int getLodLevel() const { return lodLevel; }
 
-    void Draw(Shader &shader)
+    // Advances the body along its orbit, must be called once per frame before drawing
+    void Update()
     {
         float time = glfwGetTime();
-        glm::mat4 planetModelMat = glm::mat4(1.0f);
-        shader.use();
+        planetModelMat = glm::mat4(1.0f);
 
         float theta = orbit.speed*time + orbit.startTheta;
         float r = sqrt(1/(pow((cos(theta)/(orbit.a*orbitScaleModifier)),2) + pow(sin(theta)/(orbit.b*orbitModifier),2) ));
@@ -183,27 +245,79 @@ public:
         planetModelMat = glm::rotate(planetModelMat, glm::degrees(0.01f*time), glm::vec3(0,1.0,0));
         planetModelMat = glm::rotate(planetModelMat, glm::degrees(6*sin(orbit.startTheta)), glm::vec3(0,1.0,0));
 
-        glm::mat4 projection = glm::perspective(glm::radians(programState->camera.Zoom),
-                                                (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = programState->camera.GetViewMatrix();
-
-
-        shader.setMat4("model", planetModelMat);
-        shader.setFloat("scale", scale + sunScaleModifier*sunPlanet);
-        shader.setInt("HasTexture", (int)model.hasTexture());
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
-
-        glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(view*planetModelMat)));
-        shader.setMat3("normalMatrix", normalMatrix);
-
         position = glm::vec3(
             planetModelMat[3][0],
             planetModelMat[3][1],
             planetModelMat[3][2]
         );
+    }
+
+    // World space bounds, the shader scales the whole model matrix translation too
+    BoundingSphere getBounds() const
+    {
+        const float currentScale = scale + sunScaleModifier*sunPlanet;
+        return BoundingSphere{currentScale * position, currentScale * PlanetModel::SphereRadius};
+    }
+
+    // Picks the sphere LOD from the radius the planet covers on screen
+    void UpdateLod(const Camera &camera)
+    {
+        const BoundingSphere bounds = getBounds();
+        const float distance = glm::length(bounds.center - camera.Position);
+
+        screenRadius = SCR_HEIGHT;
+        if(distance > bounds.radius) {
+            screenRadius = bounds.radius / (distance * tan(glm::radians(camera.Zoom) / 2)) * SCR_HEIGHT / 2;
+        }
+
+        lodLevel = SphereLodChain::SelectLevel(screenRadius, lodLevel);
+    }
+
+    // Asks for the texture at the size it is seen with, after UpdateLod: the equirectangular
+    // map wraps around the equator, which spans about 2 pi times the screen radius.
+    // Bodies with a layer are drawn from the renderer's array, the sun from its own texture.
+    void RequestTexture(PlanetRenderer &renderer) const
+    {
+        const float screenPixels = 2 * glm::pi<float>() * screenRadius;
+        if(layer >= 0) {
+            renderer.RequestLayer(layer, screenPixels);
+        }
+        else {
+            ResidencyManager::Shared().Request(model.getTexture(), screenPixels);
+        }
+    }
+
+    // Draws with the ObjectData block written by Queue
+    void Draw(Shader &shader)
+    {
+        shader.use();
+        RenderState::BindUniformBufferRange(ObjectDataBinding, objectBuffer, objectOffset, sizeof(ObjectData));
+        model.draw(lodLevel);
+    }
+
+    // Queues the body as an opaque draw of its own, for the sun which does not go through the PlanetRenderer.
+    // The transform goes to the frame's stream buffer, view and projection come from the FrameData block.
+    void Queue(RenderQueue &queue, Shader &shader, StreamBuffer &stream, const glm::vec3 &cameraPosition)
+    {
+        glm::mat4 view = programState->camera.GetViewMatrix();
+        glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(view*planetModelMat)));
+        const StreamAllocation object = writeObjectData(stream, planetModelMat, normalMatrix,
+                                                        scale + sunScaleModifier*sunPlanet);
+        if(!object.pointer) {
+            return;
+        }
+        objectBuffer = stream.Id();
+        objectOffset = object.offset;
 
-        model.draw();
+        queuedShader = &shader;
+        queue.Submit(queue.Key(OpaquePass, BlendNone, shader.ID, 0, glm::length(getBounds().center - cameraPosition)),
+                     &Planet::drawPacket, this);
+    }
+
+    void Submit(PlanetRenderer &renderer, const glm::mat4 &view)
+    {
+        glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(view*planetModelMat)));
+        renderer.Submit(planetModelMat, normalMatrix, scale + sunScaleModifier*sunPlanet, layer, lodLevel);
     }
 
     float getScale() const { return scale; }
@@ -222,9 +336,25 @@ void calculateCenterOfMass(const vector<Planet*> &planets)
 }
 
 
-void DrawImGui(ProgramState *programState);
+void DrawImGui(ProgramState *programState, const PlanetRenderer &planetRenderer, const IndirectModel &backpacks,
+               const CullingStage &culling, const RenderQueue &renderQueue, const StreamBuffer &frameStream,
+               const TextureStreamer &textureStreamer, const ShaderHotReload &shaderHotReload,
+               const vector<Planet*> &bodies);
+
+void benchShaderBuilds(unsigned int count);
+
+int main(int argc, char **argv) {
+    bool benchScene = false, shaderBench = false;
+    for(int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if(arg == "--bench")
+            benchScene = true;
+        else if(arg == "--shader-bench")
+            shaderBench = true;
+        else if(arg == "--texture-budget" && i + 1 < argc)
+            ResidencyManager::Shared().SetBudget((size_t)std::stoul(argv[++i]) << 20);
+    }
 
-int main() {
     srand(time(NULL));
     // glfw: initialize and configure
     // ------------------------------
@@ -259,9 +389,12 @@ int main() {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    GLExtensions::Load((GLADloadproc) glfwGetProcAddress);
 
-    // tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
-    stbi_set_flip_vertically_on_load(true);
+    if(shaderBench) {
+        benchShaderBuilds(4);
+        benchShaderBuilds(40);
+    }
 
     programState = new ProgramState;
     programState->LoadFromFile("resources/program_state.txt");
@@ -280,36 +413,124 @@ int main() {
 
     // configure global opengl state
     // -----------------------------
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
+    RenderState::Invalidate();
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    RenderState::SetViewport(0, 0, framebufferWidth, framebufferHeight);
+    RenderState::SetDepthTest(true);
+    RenderState::SetCullFace(true);
+
+    RenderState::SetBlend(true);
+    RenderState::SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // build and compile shaders: every program starts compiling now and the driver
+    // works on them while the models load, warm starts load them from the cache
+    // -------------------------
+    const double shaderStart = glfwGetTime();
+    ShaderBuildQueue shaderQueue;
+    Shader &sunShader = shaderQueue.Add("resources/shaders/2.model_lighting.vs","resources/shaders/sun_shader.fs");
+    // the backpack reads its per-mesh data from storage buffers when multi-draw indirect is there, else from uniforms
+    Shader &backpackShader = shaderQueue.Add("resources/shaders/backpack_indirect.vs", "resources/shaders/backpack_indirect.fs",
+                                             GLExtensions::HasMultiDrawIndirect ? std::vector<std::string>{"INDIRECT_DRAW"}
+                                                                                : std::vector<std::string>{});
+    Shader &skyboxShader = shaderQueue.Add("resources/shaders/skybox.vs","resources/shaders/skybox.fs");
+
+    // planet variants are built on first use, except the textured one every planet needs
+    ShaderPermutations planetShaders("resources/shaders/planet_instanced.vs", "resources/shaders/2.model_lighting.fs");
+    planetShaders.SetInitializer([](Shader &shader) {
+        shader.use();
+        shader.setFloat("sphereRadius", PlanetModel::SphereRadius);
+    });
+    planetShaders.Prefetch(FeatureTexture, shaderQueue);
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    shaderQueue.Submit();
+    const double shaderSubmitted = glfwGetTime();
 
-    // build and compile shaders
-    // -------------------------
-    Shader ourShader("resources/shaders/2.model_lighting.vs", "resources/shaders/2.model_lighting.fs");
-    Shader sunShader("resources/shaders/2.model_lighting.vs","resources/shaders/sun_shader.fs");
-    Shader backpackShader("resources/shaders/backpack_shader.vs","resources/shaders/backpack_shader.fs");
+    // every per-frame upload (camera, lights, transforms, instances) is written into this ring
+    StreamBuffer frameStream(4 << 20);
 
-    // load models
+    // load models, their images are decoded on the shared pool while the meshes are processed
     // -----------
+    const double imageStart = glfwGetTime();
     Planet sunModel("resources/textures/sun.jpg", 1, 1, 0.3, 1, true);
     Planet earth("resources/textures/earth.jpg", 52, 50, 0.1);
     Planet mars("resources/textures/mars.jpg", 57, 55, 0.2,0.5);
     Planet venus("resources/textures/venus.jpg", 62, 60, 0.1);
     Planet jupiter("resources/textures/jupiter_tp.jpg", 72, 70, 0.15);
-    //sunModel.SetShaderTextureNamePrefix("material.");
 
-    // Load backpack
+    // Load backpack, all of its meshes and every copy are drawn together
     Model backpackModel("resources/objects/backpack/backpack.obj");
-    backpackModel.SetShaderTextureNamePrefix("material.");
+    backpackModel.doubleSided = true;
+
+    vector<string> faces {
+        "resources/skybox/blue/bkg1_right.png",
+        "resources/skybox/blue/bkg1_left.png",
+        "resources/skybox/blue/bkg1_top.png",
+        "resources/skybox/blue/bkg1_bot.png",
+        "resources/skybox/blue/bkg1_front.png",
+        "resources/skybox/blue/bkg1_back.png",
+    };
+    Skybox skybox;
+    skybox.Load(faces, "resources/skybox/blue/skybox.ktx");
+
+    // nothing waits for the images: every texture samples as a placeholder until the streamer
+    // has uploaded it, and the texture arrays below copy each one again once it is in
+    TextureStreamer &textureStreamer = TextureStreamer::Shared();
+    bool texturesReported = false;
+
+    IndirectModel backpacks(backpackModel.meshes, frameStream, backpackModel.doubleSided);
+
+    std::vector<glm::mat4> backpackTransforms {glm::translate(glm::mat4(1), glm::vec3(0,5,0))};
+    if(benchScene) {
+        for(unsigned int i=0;i<BENCH_BACKPACK_GRID*BENCH_BACKPACK_GRID*BENCH_BACKPACK_GRID;++i) {
+            const glm::vec3 cell(i % BENCH_BACKPACK_GRID, i / BENCH_BACKPACK_GRID % BENCH_BACKPACK_GRID,
+                                 i / (BENCH_BACKPACK_GRID*BENCH_BACKPACK_GRID));
+            backpackTransforms.push_back(glm::translate(glm::mat4(1), glm::vec3(-20, 10, -20) + cell * 4.0f));
+        }
+    }
 
 
     std::vector<Planet*> planets {
         &earth, &mars, &venus, &jupiter
     };
 
+    // bodies listed in the Properties window
+    std::vector<Planet*> namedBodies {
+        &sunModel, &earth, &mars, &venus, &jupiter
+    };
+
+    // the layers stay block compressed when bake_textures has baked every planet map at the layer size
+    std::vector<std::string> planetTextures;
+    for(const Planet *p : planets) {
+        planetTextures.push_back(p->getTexturePath());
+    }
+    PlanetRenderer planetRenderer(sunModel.getModel().getLods(), frameStream,
+                                  PlanetRenderer::LayerFormatOf(planetTextures));
+    for(Planet *p : planets) {
+        p->setLayer(planetRenderer.AddTexture(p->getModel().getTexture(), p->getTexturePath(),
+                                              p->getModel().isTranslucent()));
+        // compressed layers were read from the baked files, the planet's own copy would only take memory
+        if(planetRenderer.CompressedLayers()) {
+            p->getModel().releaseTexture();
+        }
+    }
+
+    // Bench scene: clone the textured planets onto random orbits, they all share
+    // the sphere and textures so the draw call count stays the same
+    std::vector<Planet> benchPlanets;
+    if(benchScene) {
+        const unsigned int templateCount = planets.size();
+        benchPlanets.reserve(BENCH_BODIES);
+        for(unsigned int i=0;i<BENCH_BODIES;++i) {
+            float a = 30 + 1.0*random()/RAND_MAX * 300;
+            float b = a - 1.0*random()/RAND_MAX * 5;
+            benchPlanets.emplace_back(*planets[i % templateCount], a, b);
+        }
+        for(Planet &p : benchPlanets) {
+            planets.push_back(&p);
+        }
+    }
+
     PointLight& pointLight = programState->pointLight;
     pointLight.position = programState->sunPosition;
     pointLight.ambient = glm::vec3(0.2);
@@ -328,18 +549,34 @@ int main() {
 
     calculateCenterOfMass(planets);
 
-    vector<string> faces {
-        "resources/skybox/blue/bkg1_right.png",
-        "resources/skybox/blue/bkg1_left.png",
-        "resources/skybox/blue/bkg1_top.png",
-        "resources/skybox/blue/bkg1_bot.png",
-        "resources/skybox/blue/bkg1_front.png",
-        "resources/skybox/blue/bkg1_back.png",
-    };
-    Skybox skybox;
-    skybox.Load(faces);
+    // only waits for what the driver has not finished while loading
+    const double shaderWaitStart = glfwGetTime();
+    shaderQueue.Finish();
+    const double shaderEnd = glfwGetTime();
+    std::cout << "Shaders: " << shaderQueue.Size() << " programs submitted in " << (shaderSubmitted - shaderStart) * 1000
+              << " ms, ready after " << (shaderEnd - shaderStart) * 1000 << " ms, "
+              << (shaderEnd - shaderWaitStart) * 1000 << " ms spent waiting, "
+              << ProgramCache::Hits() << " from the cache ("
+              << (ProgramCache::Hits() == shaderQueue.Size() ? "warm" : "cold") << " start)" << std::endl;
+
+    // sampler units, set again whenever the program is reloaded
+    backpackShader.SetLinkCallback([](Shader &shader) {
+        IndirectModel::SetupSamplers(shader);
+    });
+
+    // spheres are stored as unit spheres
+    sunShader.ExpectUniforms({"sphereRadius"});
+    sunShader.SetLinkCallback([](Shader &shader) {
+        shader.use();
+        shader.setFloat("sphereRadius", PlanetModel::SphereRadius);
+    });
+
+    // edited shaders are rebuilt in the background and swapped in once they link
+    ShaderHotReload shaderHotReload("resources/shaders");
 
-    Shader skyboxShader("resources/shaders/skybox.vs","resources/shaders/skybox.fs");
+    CullingStage culling;
+    FrameUniforms frameUniforms;
+    RenderQueue renderQueue;
 
     // render loop
     // -----------
@@ -354,31 +591,48 @@ int main() {
         // -----
         processInput(window);
 
+        RenderState::BeginFrame();
+        frameStream.BeginFrame();
+        shaderHotReload.Update();
+        textureStreamer.Update();
+        ResidencyManager::Shared().Update();
+        if(!texturesReported && textureStreamer.PendingCount() == 0) {
+            ImageDecodePool &imagePool = ImageDecodePool::Shared();
+            std::cout << "Images: " << imagePool.DecodedCount() << " decoded on " << imagePool.ThreadCount()
+                      << " threads, " << imagePool.DecodeSeconds() * 1000 << " ms of decoding, all "
+                      << textureStreamer.CompletedCount() << " textures streamed in "
+                      << (glfwGetTime() - imageStart) * 1000 << " ms" << std::endl;
+            texturesReported = true;
+        }
 
         // render
         // ------
         glClearColor(programState->clearColor.r, programState->clearColor.g, programState->clearColor.b, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Draw skybox
-        skybox.Draw(programState->camera, skyboxShader);
-        
         programState->sunPosition = sunModel.getPosition();
         pointLight.position = programState->sunPosition;
 
-        // don't forget to enable shader before setting uniforms
-        ourShader.use();
-        ourShader.setVec3("pointLight.position", pointLight.position);
-        ourShader.setVec3("pointLight.ambient", pointLight.ambient);
-        ourShader.setVec3("pointLight.diffuse", pointLight.diffuse);
-        ourShader.setVec3("pointLight.specular", pointLight.specular);
-        ourShader.setFloat("pointLight.constant", pointLight.constant);
-        ourShader.setFloat("pointLight.linear", pointLight.linear);
-        ourShader.setFloat("pointLight.quadratic", pointLight.quadratic);
-        ourShader.setVec3("viewPosition", programState->camera.Position);
-        ourShader.setFloat("material.shininess", 32.0f);
         // view/projection transformations
+        glm::mat4 projection = glm::perspective(glm::radians(programState->camera.Zoom),
+                                            (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, 100.0f);
+        glm::mat4 view = programState->camera.GetViewMatrix();
+
+        // camera and lights for every program, through the FrameData and LightData blocks
+        frameUniforms.SetCamera(view, projection, programState->camera.Position);
+        frameUniforms.ClearLights();
+        frameUniforms.AddPointLight(pointLight.position, pointLight.ambient, pointLight.diffuse, pointLight.specular,
+                                    pointLight.constant, pointLight.linear, pointLight.quadratic);
+        frameUniforms.Upload(frameStream);
 
+        // everything below is queued and drawn sorted by renderQueue.Execute, depth keys span the far plane
+        renderQueue.Begin(100.0f);
+        const glm::vec3 &cameraPosition = programState->camera.Position;
+
+        skybox.Queue(renderQueue, skyboxShader);
+        // a cube face spans 90 degrees, seen through the vertical field of view
+        ResidencyManager::Shared().Request(skybox.textureId,
+                                           SCR_HEIGHT / tan(glm::radians(programState->camera.Zoom) / 2));
 
         /*
         printf("Sun x y z: %.2f %.2f %.2f\n", 
@@ -394,42 +648,51 @@ int main() {
         );
         */
 
-        sunModel.Draw(sunShader);
-
+        // Gather the bounds of everything that may be drawn and test them in one batch,
+        // the sun is at index 0, planet i at index 1 + i and every mesh of every backpack follows
+        culling.Begin();
+        sunModel.Update();
+        culling.Add(sunModel.getBounds());
         for(Planet *p : planets) {
-            p->Draw(ourShader);
+            p->Update();
+            culling.Add(p->getBounds());
         }
+        const size_t backpackBounds = culling.Size();
+        for(const glm::mat4 &transform : backpackTransforms) {
+            backpacks.AddBounds(culling, transform);
+        }
+        culling.Run(projection * view);
 
-        // Draw backpack
-        {
-            backpackShader.use();
-            backpackShader.setVec3("pointLight.position", pointLight.position);
-            backpackShader.setVec3("pointLight.ambient", pointLight.ambient);
-            backpackShader.setVec3("pointLight.diffuse", pointLight.diffuse);
-            backpackShader.setVec3("pointLight.specular", pointLight.specular);
-            backpackShader.setFloat("pointLight.constant", pointLight.constant);
-            backpackShader.setFloat("pointLight.linear", pointLight.linear);
-            backpackShader.setFloat("pointLight.quadratic", pointLight.quadratic);
-            backpackShader.setVec3("viewPosition", programState->camera.Position);
-            backpackShader.setFloat("material.shininess", 32.0f);
-
-            glm::mat4 projection = glm::perspective(glm::radians(programState->camera.Zoom),
-                                                (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, 100.0f);
-            glm::mat4 view = programState->camera.GetViewMatrix();
-
-            glm::mat4 model = glm::mat4(1);
-            model = glm::translate(model, glm::vec3(0,5,0));
-
-            backpackShader.setMat4("projection", projection);
-            backpackShader.setMat4("view", view);
-            backpackShader.setMat4("model", model);
+        if(culling.IsVisible(0)) {
+            sunModel.UpdateLod(programState->camera);
+            sunModel.RequestTexture(planetRenderer);
+            sunModel.Queue(renderQueue, sunShader, frameStream, cameraPosition);
+        }
 
-            backpackModel.Draw(backpackShader);
+        planetRenderer.Begin();
+        for(size_t i = 0; i < planets.size(); ++i) {
+            if(culling.IsVisible(1 + i)) {
+                planets[i]->UpdateLod(programState->camera);
+                planets[i]->RequestTexture(planetRenderer);
+                planets[i]->Submit(planetRenderer, view);
+            }
+        }
+        planetRenderer.Queue(renderQueue, planetShaders, cameraPosition);
 
+        backpacks.Begin();
+        for(size_t i = 0; i < backpackTransforms.size(); ++i) {
+            backpacks.AddInstance(backpackTransforms[i],
+                                  culling.Visibility(backpackBounds + i * backpacks.MeshCount()));
         }
+        backpacks.Queue(renderQueue, backpackShader, cameraPosition);
+
+        frameStream.Commit();
+        renderQueue.Execute();
+        frameStream.EndFrame();
 
         if (programState->ImGuiEnabled)
-            DrawImGui(programState);
+            DrawImGui(programState, planetRenderer, backpacks, culling, renderQueue, frameStream, textureStreamer,
+                      shaderHotReload, namedBodies);
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
@@ -491,7 +754,7 @@ void processInput(GLFWwindow *window) {
 void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
     // make sure the viewport matches the new window dimensions; note that width and
     // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    RenderState::SetViewport(0, 0, width, height);
 }
 
 // glfw: whenever the mouse moves, this callback is called
@@ -519,7 +782,60 @@ void scroll_callback(GLFWwindow *window, double xoffset, double yoffset) {
     programState->camera.ProcessMouseScroll(yoffset);
 }
 
-void DrawImGui(ProgramState *programState) {
+// Builds count distinct programs from the scene's shaders, first one after another and
+// then through a ShaderBuildQueue, and prints both times. The cache is off and every
+// program gets a unique define so neither run reuses an earlier compile.
+void benchShaderBuilds(unsigned int count) {
+    static const char *sources[][2] = {
+        {"resources/shaders/2.model_lighting.vs", "resources/shaders/sun_shader.fs"},
+        {"resources/shaders/backpack_indirect.vs", "resources/shaders/backpack_indirect.fs"},
+        {"resources/shaders/skybox.vs", "resources/shaders/skybox.fs"},
+        {"resources/shaders/planet_instanced.vs", "resources/shaders/2.model_lighting.fs"},
+    };
+    const unsigned int sourceCount = sizeof(sources) / sizeof(sources[0]);
+    const std::string salt = "BENCH_" + std::to_string(rand()) + "_";
+
+    const bool cacheEnabled = ProgramCache::Enabled;
+    ProgramCache::Enabled = false;
+    std::vector<unsigned int> programs;
+
+    double start = glfwGetTime();
+    for(unsigned int i = 0; i < count; ++i) {
+        Shader shader(sources[i % sourceCount][0], sources[i % sourceCount][1], nullptr,
+                      {salt + "SEQUENTIAL_" + std::to_string(i)});
+        programs.push_back(shader.ID);
+    }
+    const double sequential = glfwGetTime() - start;
+
+    start = glfwGetTime();
+    {
+        ShaderBuildQueue queue;
+        std::vector<Shader*> queued;
+        for(unsigned int i = 0; i < count; ++i) {
+            queued.push_back(&queue.Add(sources[i % sourceCount][0], sources[i % sourceCount][1],
+                                        {salt + "QUEUED_" + std::to_string(i)}));
+        }
+        queue.Finish();
+        for(Shader *shader : queued) {
+            programs.push_back(shader->ID);
+        }
+    }
+    const double queued = glfwGetTime() - start;
+
+    RenderState::UseProgram(0);
+    for(unsigned int program : programs) {
+        glDeleteProgram(program);
+    }
+    ProgramCache::Enabled = cacheEnabled;
+
+    std::cout << "Shader bench: " << count << " programs, one by one " << sequential * 1000 << " ms, queued "
+              << queued * 1000 << " ms" << std::endl;
+}
+
+void DrawImGui(ProgramState *programState, const PlanetRenderer &planetRenderer, const IndirectModel &backpacks,
+               const CullingStage &culling, const RenderQueue &renderQueue, const StreamBuffer &frameStream,
+               const TextureStreamer &textureStreamer, const ShaderHotReload &shaderHotReload,
+               const vector<Planet*> &bodies) {
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
@@ -531,6 +847,65 @@ void DrawImGui(ProgramState *programState) {
         ImGui::SliderFloat("Sunscale modifier", &sunScaleModifier, 0, 1.0);
         ImGui::SliderFloat("Orbit modifier", &orbitScaleModifier, 1, 3.0);
         ImGui::ColorEdit3("Background color", (float *) &programState->clearColor);
+        ImGui::Text("Planets: %u in %u draw calls", planetRenderer.InstanceCount(), planetRenderer.DrawCalls());
+        ImGui::Text("Backpacks: %u, %u of %u mesh draws in %u draw calls%s", backpacks.InstanceCount(),
+                    backpacks.VisibleDraws(), backpacks.InstanceCount() * backpacks.CommandCount(), backpacks.DrawCalls(),
+                    GLExtensions::HasMultiDrawIndirect ? " (multi-draw indirect)" : "");
+        for(const Planet *p : bodies) {
+            const string &path = p->getTexturePath();
+            ImGui::Text("%s: LOD %d", path.substr(path.find_last_of('/') + 1).c_str(), p->getLodLevel());
+        }
+        for(int i=0;i<SphereLodChain::LevelCount;++i) {
+            ImGui::Text("LOD %d (%dx%d): %u planets", i, SphereLodChain::LevelSegments[i],
+                        SphereLodChain::LevelSegments[i], planetRenderer.LevelInstanceCount(i));
+        }
+        ImGui::End();
+    }
+
+    {
+        ImGui::Begin("Render state");
+        ImGui::Text("GL state calls issued: %u", RenderState::CallsIssued());
+        ImGui::Text("GL state calls skipped: %u", RenderState::CallsSkipped());
+        ImGui::Text("Culling: %zu submitted, %zu culled", culling.Submitted(), culling.Culled());
+        ImGui::Text("Draw packets: %zu (%zu background, %zu opaque, %zu transparent)", renderQueue.PacketCount(),
+                    renderQueue.PassPacketCount(BackgroundPass), renderQueue.PassPacketCount(OpaquePass),
+                    renderQueue.PassPacketCount(TransparentPass));
+        ImGui::Text("Stream buffer: %zu of %zu KB, %u stalls%s", frameStream.UsedBytes() / 1024,
+                    frameStream.FrameBytes() / 1024, frameStream.Stalls(),
+                    frameStream.IsPersistent() ? " (persistent)" : "");
+        ImGui::Text("Texture streaming: %u pending (%.1f MB decoded), %.1f of %.1f MB uploaded this frame",
+                    textureStreamer.PendingCount(), textureStreamer.PendingBytes() / 1048576.0,
+                    textureStreamer.FrameUploadedBytes() / 1048576.0, textureStreamer.FrameBudget() / 1048576.0);
+        ImGui::Text("Texture registry: %u textures, %u loads, %u shared", TextureRegistry::Shared().Count(),
+                    TextureRegistry::Shared().Loads(), TextureRegistry::Shared().Hits());
+        ResidencyManager &residency = ResidencyManager::Shared();
+        ImGui::Text("Residency: %.1f of %.1f MB resident, %u pending uploads, %u evictions, %u promotions",
+                    residency.ResidentBytes() / 1048576.0, residency.Budget() / 1048576.0,
+                    residency.PendingUploads(), residency.Evictions(), residency.Promotions());
+        int budgetMegabytes = residency.Budget() >> 20;
+        if(ImGui::SliderInt("Texture budget (MB)", &budgetMegabytes, 16, 1024)) {
+            residency.SetBudget((size_t)budgetMegabytes << 20);
+        }
+        ImGui::Text("Shader reloads: %u%s", shaderHotReload.ReloadCount(),
+                    shaderHotReload.IsWatching() ? "" : " (not watching)");
+        ImGui::End();
+    }
+
+    // programs whose last build failed, they keep running their previous version
+    bool shaderErrors = false;
+    for(const Shader *shader : Shader::Instances()) {
+        if(shader->BuildLog().empty()) {
+            continue;
+        }
+        if(!shaderErrors) {
+            ImGui::Begin("Shader errors");
+            shaderErrors = true;
+        }
+        ImGui::TextColored(ImVec4(1, 0.4f, 0.4f, 1), "%s + %s", shader->vPath.c_str(), shader->fPath.c_str());
+        ImGui::TextUnformatted(shader->BuildLog().c_str());
+        ImGui::Separator();
+    }
+    if(shaderErrors) {
         ImGui::End();
     }
 
@@ -0,0 +1,218 @@
+#include "BlockCompression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    uint16_t packRgb565(const float color[3])
+    {
+        const int r = std::min(31, std::max(0, (int)std::lround(color[0] * 31.0f / 255.0f)));
+        const int g = std::min(63, std::max(0, (int)std::lround(color[1] * 63.0f / 255.0f)));
+        const int b = std::min(31, std::max(0, (int)std::lround(color[2] * 31.0f / 255.0f)));
+        return (uint16_t)(r << 11 | g << 5 | b);
+    }
+
+    void unpackRgb565(uint16_t packed, int color[3])
+    {
+        const int r = packed >> 11 & 31, g = packed >> 5 & 63, b = packed & 31;
+        color[0] = r << 3 | r >> 2;
+        color[1] = g << 2 | g >> 4;
+        color[2] = b << 3 | b >> 2;
+    }
+
+    // Endpoints are the extremes of the block along its principal axis (range fit), found by
+    // power iteration on the covariance. Always uses the 4 color mode, as BC3 requires.
+    void compressColor(const unsigned char block[64], unsigned char out[8])
+    {
+        float mean[3] = {0, 0, 0};
+        for(int i = 0; i < 16; ++i) {
+            for(int c = 0; c < 3; ++c) {
+                mean[c] += block[i * 4 + c] / 16.0f;
+            }
+        }
+        float covariance[6] = {0, 0, 0, 0, 0, 0};
+        for(int i = 0; i < 16; ++i) {
+            const float r = block[i * 4] - mean[0], g = block[i * 4 + 1] - mean[1], b = block[i * 4 + 2] - mean[2];
+            covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+            covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+        }
+        float axis[3] = {1, 1, 1};
+        for(int iteration = 0; iteration < 8; ++iteration) {
+            const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+            const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+            const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+            const float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+            if(length < 1e-6f) {
+                break;
+            }
+            axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+        }
+
+        float minProjection = 1e30f, maxProjection = -1e30f;
+        for(int i = 0; i < 16; ++i) {
+            const float projection = (block[i * 4] - mean[0]) * axis[0] + (block[i * 4 + 1] - mean[1]) * axis[1]
+                                     + (block[i * 4 + 2] - mean[2]) * axis[2];
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+        const float axisLength = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+        float low[3], high[3];
+        for(int c = 0; c < 3; ++c) {
+            const float direction = axisLength > 0 ? axis[c] / axisLength : 0;
+            low[c] = mean[c] + direction * minProjection;
+            high[c] = mean[c] + direction * maxProjection;
+        }
+
+        uint16_t color0 = packRgb565(high), color1 = packRgb565(low);
+        if(color0 < color1) {
+            std::swap(color0, color1);
+        }
+
+        uint32_t indices = 0;
+        if(color0 != color1) {
+            int palette[4][3];
+            unpackRgb565(color0, palette[0]);
+            unpackRgb565(color1, palette[1]);
+            for(int c = 0; c < 3; ++c) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            for(int i = 0; i < 16; ++i) {
+                int best = 0, bestError = 1 << 30;
+                for(int p = 0; p < 4; ++p) {
+                    const int r = block[i * 4] - palette[p][0], g = block[i * 4 + 1] - palette[p][1],
+                              b = block[i * 4 + 2] - palette[p][2];
+                    const int error = r * r + g * g + b * b;
+                    if(error < bestError) {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                indices |= (uint32_t)best << (2 * i);
+            }
+        }
+
+        std::memcpy(out, &color0, 2);
+        std::memcpy(out + 2, &color1, 2);
+        std::memcpy(out + 4, &indices, 4);
+    }
+
+    // 8 value mode between the block's extremes
+    void compressAlpha(const unsigned char block[64], unsigned char out[8])
+    {
+        int alpha0 = 0, alpha1 = 255;
+        for(int i = 0; i < 16; ++i) {
+            alpha0 = std::max(alpha0, (int)block[i * 4 + 3]);
+            alpha1 = std::min(alpha1, (int)block[i * 4 + 3]);
+        }
+
+        uint64_t indices = 0;
+        if(alpha0 != alpha1) {
+            int palette[8] = {alpha0, alpha1};
+            for(int p = 1; p < 7; ++p) {
+                palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+            }
+            for(int i = 0; i < 16; ++i) {
+                int best = 0, bestError = 256;
+                for(int p = 0; p < 8; ++p) {
+                    const int error = std::abs(block[i * 4 + 3] - palette[p]);
+                    if(error < bestError) {
+                        bestError = error;
+                        best = p;
+                    }
+                }
+                indices |= (uint64_t)best << (3 * i);
+            }
+        }
+
+        out[0] = (unsigned char)alpha0;
+        out[1] = (unsigned char)alpha1;
+        for(int i = 0; i < 6; ++i) {
+            out[2 + i] = (unsigned char)(indices >> (8 * i));
+        }
+    }
+}
+
+unsigned int blockBytes(BlockFormat format)
+{
+    return format == BlockFormatBC1 ? 8 : 16;
+}
+
+std::vector<unsigned char> compressImage(const unsigned char *rgba, int width, int height, BlockFormat format)
+{
+    const int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+    std::vector<unsigned char> compressed(blocksWide * blocksHigh * blockBytes(format));
+    unsigned char *out = &compressed[0];
+
+    unsigned char block[64];
+    for(int blockY = 0; blockY < blocksHigh; ++blockY) {
+        for(int blockX = 0; blockX < blocksWide; ++blockX) {
+            for(int y = 0; y < 4; ++y) {
+                const int sourceY = std::min(blockY * 4 + y, height - 1);
+                for(int x = 0; x < 4; ++x) {
+                    const int sourceX = std::min(blockX * 4 + x, width - 1);
+                    std::memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sourceY * width + sourceX) * 4, 4);
+                }
+            }
+            if(format == BlockFormatBC3) {
+                compressAlpha(block, out);
+                out += 8;
+            }
+            compressColor(block, out);
+            out += 8;
+        }
+    }
+    return compressed;
+}
+
+std::vector<unsigned char> downsample(const std::vector<unsigned char> &rgba, int width, int height)
+{
+    const int halfWidth = std::max(width / 2, 1), halfHeight = std::max(height / 2, 1);
+    std::vector<unsigned char> half((size_t)halfWidth * halfHeight * 4);
+    for(int y = 0; y < halfHeight; ++y) {
+        const int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+        for(int x = 0; x < halfWidth; ++x) {
+            const int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+            for(int c = 0; c < 4; ++c) {
+                const int sum = rgba[((size_t)y0 * width + x0) * 4 + c] + rgba[((size_t)y0 * width + x1) * 4 + c]
+                                + rgba[((size_t)y1 * width + x0) * 4 + c] + rgba[((size_t)y1 * width + x1) * 4 + c];
+                half[((size_t)y * halfWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+    return half;
+}
+
+std::vector<unsigned char> resize(const std::vector<unsigned char> &rgba, int width, int height, int newWidth,
+                                  int newHeight)
+{
+    std::vector<unsigned char> source = rgba;
+    while(width >= newWidth * 2 && height >= newHeight * 2) {
+        source = downsample(source, width, height);
+        width /= 2;
+        height /= 2;
+    }
+
+    std::vector<unsigned char> resized((size_t)newWidth * newHeight * 4);
+    for(int y = 0; y < newHeight; ++y) {
+        // texel centers of the new image in the source, clamped at the edges
+        const float sourceY = std::min(std::max((y + 0.5f) * height / newHeight - 0.5f, 0.0f), height - 1.0f);
+        const int y0 = (int)sourceY, y1 = std::min(y0 + 1, height - 1);
+        const float fy = sourceY - y0;
+        for(int x = 0; x < newWidth; ++x) {
+            const float sourceX = std::min(std::max((x + 0.5f) * width / newWidth - 0.5f, 0.0f), width - 1.0f);
+            const int x0 = (int)sourceX, x1 = std::min(x0 + 1, width - 1);
+            const float fx = sourceX - x0;
+            for(int c = 0; c < 4; ++c) {
+                const float top = source[((size_t)y0 * width + x0) * 4 + c] * (1 - fx)
+                                  + source[((size_t)y0 * width + x1) * 4 + c] * fx;
+                const float bottom = source[((size_t)y1 * width + x0) * 4 + c] * (1 - fx)
+                                     + source[((size_t)y1 * width + x1) * 4 + c] * fx;
+                resized[((size_t)y * newWidth + x) * 4 + c] = (unsigned char)(top * (1 - fy) + bottom * fy + 0.5f);
+            }
+        }
+    }
+    return resized;
+}
@@ -0,0 +1,29 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <vector>
+
+enum BlockFormat
+{
+    // 4 bits per pixel, opaque RGB
+    BlockFormatBC1,
+    // 8 bits per pixel, BC1 color plus an interpolated alpha block
+    BlockFormatBC3
+};
+
+// Bytes of one 4x4 block
+unsigned int blockBytes(BlockFormat format);
+
+// Compresses a tightly packed RGBA8 image, rows top to bottom. Sizes that are not a
+// multiple of 4 are padded by repeating the last row and column.
+std::vector<unsigned char> compressImage(const unsigned char *rgba, int width, int height, BlockFormat format);
+
+// Halves an RGBA8 image with a box filter, odd sizes round down and never go below 1
+std::vector<unsigned char> downsample(const std::vector<unsigned char> &rgba, int width, int height);
+
+// Scales an RGBA8 image to any size: box filtered by halves while it is at least twice as large,
+// then bilinear, like the GPU copy into a texture array layer
+std::vector<unsigned char> resize(const std::vector<unsigned char> &rgba, int width, int height, int newWidth,
+                                  int newHeight);
+
+#endif
@@ -0,0 +1,252 @@
+// Offline texture baker: decodes source images once, builds their mip chains with a box
+// filter and writes them block compressed into KTX files the runtime uploads as they are.
+//
+//   asset_baker [--format bc1|bc3|auto] [--flip] [--max-size N] [--size WxH] image...
+//       bakes every image next to itself, earth.jpg becomes earth.ktx. --size scales them
+//       to exactly WxH, e.g. the texture array layer they are uploaded into as they are
+//   asset_baker [--format ...] --cube -o output.ktx right left top bottom front back
+//       bakes the six faces into one cube map
+
+#include "BlockCompression.hpp"
+
+#include <KtxFile.hpp>
+#include <stb_image.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// from EXT_texture_compression_s3tc, the baker does not need a GL context
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace {
+    enum FormatChoice { ChooseBC1, ChooseBC3, ChooseAuto };
+
+    struct Options
+    {
+        FormatChoice format = ChooseAuto;
+        bool flip = false;
+        bool cube = false;
+        int maxSize = 0;
+        // 0 keeps the image size
+        int width = 0, height = 0;
+        std::string output;
+        std::vector<std::string> inputs;
+    };
+
+    struct Image
+    {
+        int width = 0, height = 0;
+        // RGBA8, rows top to bottom
+        std::vector<unsigned char> pixels;
+        bool hasAlpha = false;
+    };
+
+    void usage()
+    {
+        std::cout << "usage: asset_baker [--format bc1|bc3|auto] [--flip] [--max-size N] [--size WxH] image...\n"
+                  << "       asset_baker [--format bc1|bc3|auto] --cube -o output.ktx right left top bottom front back"
+                  << std::endl;
+    }
+
+    bool parse(int argc, char **argv, Options &options)
+    {
+        for(int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if(argument == "--format" && hasValue) {
+                const std::string value = argv[++i];
+                if(value == "bc1") options.format = ChooseBC1;
+                else if(value == "bc3") options.format = ChooseBC3;
+                else if(value == "auto") options.format = ChooseAuto;
+                else return false;
+            }
+            else if(argument == "--max-size" && hasValue) {
+                options.maxSize = std::atoi(argv[++i]);
+            }
+            else if(argument == "--size" && hasValue) {
+                if(std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2
+                   || options.width <= 0 || options.height <= 0) {
+                    return false;
+                }
+            }
+            else if(argument == "-o" && hasValue) {
+                options.output = argv[++i];
+            }
+            else if(argument == "--flip") {
+                options.flip = true;
+            }
+            else if(argument == "--cube") {
+                options.cube = true;
+            }
+            else if(argument.compare(0, 1, "-") == 0) {
+                return false;
+            }
+            else {
+                options.inputs.push_back(argument);
+            }
+        }
+        if(options.cube) {
+            return options.inputs.size() == 6 && !options.output.empty();
+        }
+        return !options.inputs.empty() && (options.output.empty() || options.inputs.size() == 1);
+    }
+
+    bool load(const std::string &path, bool flip, int maxSize, int width, int height, Image &image)
+    {
+        stbi_set_flip_vertically_on_load(flip);
+        int channels = 0;
+        unsigned char *pixels = stbi_load(path.c_str(), &image.width, &image.height, &channels, 4);
+        if(!pixels) {
+            std::cout << "ERROR::ASSET_BAKER: failed to load " << path << ": " << stbi_failure_reason() << std::endl;
+            return false;
+        }
+        image.pixels.assign(pixels, pixels + (size_t)image.width * image.height * 4);
+        stbi_image_free(pixels);
+
+        // the source may carry an alpha channel that is opaque everywhere
+        for(size_t i = 3; i < image.pixels.size() && !image.hasAlpha; i += 4) {
+            image.hasAlpha = image.pixels[i] != 255;
+        }
+
+        while(maxSize > 0 && (image.width > maxSize || image.height > maxSize)) {
+            image.pixels = downsample(image.pixels, image.width, image.height);
+            image.width = std::max(image.width / 2, 1);
+            image.height = std::max(image.height / 2, 1);
+        }
+        if(width > 0 && (image.width != width || image.height != height)) {
+            image.pixels = resize(image.pixels, image.width, image.height, width, height);
+            image.width = width;
+            image.height = height;
+        }
+        return true;
+    }
+
+    BlockFormat formatOf(FormatChoice choice, bool hasAlpha)
+    {
+        if(choice == ChooseAuto) {
+            return hasAlpha ? BlockFormatBC3 : BlockFormatBC1;
+        }
+        return choice == ChooseBC1 ? BlockFormatBC1 : BlockFormatBC3;
+    }
+
+    // Fills ktx.data with every level of every face, faces must all have the same size
+    void bake(std::vector<Image> &faces, BlockFormat format, KtxFile &ktx)
+    {
+        ktx.internalFormat = format == BlockFormatBC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+                                                      : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        // an opaque image baked to BC3 (to share an array with ones that have alpha) is still opaque
+        bool hasAlpha = false;
+        for(const Image &face : faces) {
+            hasAlpha = hasAlpha || face.hasAlpha;
+        }
+        ktx.baseInternalFormat = format == BlockFormatBC3 && hasAlpha ? GL_RGBA : GL_RGB;
+        ktx.width = faces[0].width;
+        ktx.height = faces[0].height;
+        ktx.faces = faces.size();
+        ktx.data.clear();
+
+        int width = ktx.width, height = ktx.height;
+        while(true) {
+            ktx.data.emplace_back();
+            for(Image &face : faces) {
+                ktx.data.back().push_back(compressImage(&face.pixels[0], width, height, format));
+            }
+            if(width == 1 && height == 1) {
+                break;
+            }
+            for(Image &face : faces) {
+                face.pixels = downsample(face.pixels, width, height);
+            }
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+    }
+
+    size_t bytesOf(const KtxFile &ktx)
+    {
+        size_t bytes = 0;
+        for(const std::vector<std::vector<unsigned char>> &level : ktx.data) {
+            for(const std::vector<unsigned char> &face : level) {
+                bytes += face.size();
+            }
+        }
+        return bytes;
+    }
+
+    bool write(const KtxFile &ktx, const std::string &path, size_t sourceBytes,
+               std::chrono::steady_clock::time_point start)
+    {
+        if(!ktx.Write(path)) {
+            std::cout << "ERROR::ASSET_BAKER: failed to write " << path << std::endl;
+            return false;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << path << ": " << ktx.width << "x" << ktx.height << (ktx.faces == 6 ? " cube" : "")
+                  << (ktx.orientation == KtxFile::OrientationUp ? " flipped" : "")
+                  << (ktx.internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? " BC1" : " BC3")
+                  << ", " << ktx.Levels() << " levels, " << bytesOf(ktx) / 1024 << " KB (level 0 was "
+                  << sourceBytes / 1024 << " KB as RGBA8), " << seconds * 1000.0 << " ms" << std::endl;
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if(!parse(argc, argv, options)) {
+        usage();
+        return 1;
+    }
+
+    if(options.cube) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<Image> faces(6);
+        bool hasAlpha = false;
+        for(int i = 0; i < 6; ++i) {
+            if(!load(options.inputs[i], options.flip, options.maxSize, options.width, options.height, faces[i])) {
+                return 1;
+            }
+            if(faces[i].width != faces[0].width || faces[i].height != faces[0].height
+               || faces[i].width != faces[i].height) {
+                std::cout << "ERROR::ASSET_BAKER: cube faces must be square and of the same size, "
+                          << options.inputs[i] << " is " << faces[i].width << "x" << faces[i].height << std::endl;
+                return 1;
+            }
+            hasAlpha = hasAlpha || faces[i].hasAlpha;
+        }
+        const size_t sourceBytes = (size_t)faces[0].width * faces[0].height * 4 * 6;
+        KtxFile ktx;
+        bake(faces, formatOf(options.format, hasAlpha), ktx);
+        ktx.orientation = options.flip ? KtxFile::OrientationUp : KtxFile::OrientationDown;
+        return write(ktx, options.output, sourceBytes, start) ? 0 : 1;
+    }
+
+    int failures = 0;
+    for(const std::string &input : options.inputs) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<Image> faces(1);
+        if(!load(input, options.flip, options.maxSize, options.width, options.height, faces[0])) {
+            ++failures;
+            continue;
+        }
+        const size_t sourceBytes = (size_t)faces[0].width * faces[0].height * 4;
+        KtxFile ktx;
+        bake(faces, formatOf(options.format, faces[0].hasAlpha), ktx);
+        ktx.orientation = options.flip ? KtxFile::OrientationUp : KtxFile::OrientationDown;
+        const std::string output = options.output.empty() ? KtxFile::BakedPath(input) : options.output;
+        if(!write(ktx, output, sourceBytes, start)) {
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}